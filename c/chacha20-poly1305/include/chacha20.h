@@ -4,6 +4,34 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/**
+ * @brief Keystream implementations available behind chacha20_apply().
+ */
+typedef enum {
+    CHACHA20_BACKEND_AUTO = 0, /**< Widest kernel supported by the CPU */
+    CHACHA20_BACKEND_SCALAR,   /**< Portable one-block-at-a-time code */
+    CHACHA20_BACKEND_SSSE3,    /**< 4 blocks per iteration */
+    CHACHA20_BACKEND_AVX2,     /**< 8 blocks per iteration */
+    CHACHA20_BACKEND_AVX512    /**< 16 blocks per iteration (AVX-512F) */
+} chacha20_backend_t;
+
+/**
+ * @brief Selects the keystream kernel used by chacha20_apply() and the AEAD.
+ *
+ * The selection is process-wide. Without a call, CHACHA20_BACKEND_AUTO is used.
+ * 
+ * @param[in] backend The backend to use.
+ * @return            0 on success, 1 if the running CPU does not support it.
+ */
+int chacha20_set_backend(chacha20_backend_t backend);
+
+/**
+ * @brief Returns the keystream kernel currently in use (never AUTO).
+ * 
+ * @return The active backend.
+ */
+chacha20_backend_t chacha20_get_backend(void);
+
 /**
  * @brief Generates a 64-byte keystream block for a given key, counter, and nonce.
  *  
@@ -31,6 +59,192 @@ int chacha20_apply(const uint8_t key[32], uint32_t counter,
                    const uint8_t nonce[12], const uint8_t *data_in,
                    size_t data_length, uint8_t *data_out);
 
+/**
+ * @brief HChaCha20: derives a 256-bit subkey from a key and a 128-bit nonce.
+ *
+ * Runs the 20 ChaCha20 rounds over the key and the 16-byte nonce (which
+ * takes the place of counter and nonce) and outputs words 0-3 and 12-15
+ * without the final state addition. Used by XChaCha20 to turn the first
+ * 16 bytes of its 24-byte nonce into a per-message key; callers reusing a
+ * nonce prefix may cache the subkey.
+ * 
+ * @param[in]  key    The 32-byte (256-bit) symmetric key.
+ * @param[in]  nonce  The 16-byte (128-bit) nonce.
+ * @param[out] subkey The 32-byte output buffer for the derived key.
+ */
+void hchacha20(const uint8_t key[32], const uint8_t nonce[16],
+               uint8_t subkey[32]);
+
+/**
+ * @brief ChaCha20 context holding a pre-expanded key and nonce.
+ *
+ * The 16-word input state is built once by chacha20_ctx_init(); afterwards
+ * only the block counter (word 12) changes, so a stream under one key and
+ * nonce never re-reads the raw key bytes.
+ */
+typedef struct {
+    uint32_t state[16];    /**< Input state; state[12] is the next block counter */
+    uint8_t keystream[64]; /**< Last block generated by chacha20_stream_update() */
+    size_t leftover;       /**< Unused bytes at the end of `keystream` */
+} chacha20_ctx_t;
+
+/**
+ * @brief Expands a key and nonce into a context, with the block counter at 0.
+ * 
+ * @param[out] ctx   The context to initialize.
+ * @param[in]  key   The 32-byte (256-bit) symmetric key.
+ * @param[in]  nonce The 12-byte (96-bit) nonce.
+ */
+void chacha20_ctx_init(chacha20_ctx_t *ctx, const uint8_t key[32],
+                       const uint8_t nonce[12]);
+
+/**
+ * @brief Sets the block counter used by the next context operation.
+ *
+ * Any keystream left over by chacha20_stream_update() is discarded.
+ * 
+ * @param[in,out] ctx     The context.
+ * @param[in]     counter The 32-bit block counter.
+ */
+void chacha20_ctx_set_counter(chacha20_ctx_t *ctx, uint32_t counter);
+
+/**
+ * @brief Replaces the nonce of an initialized context, keeping its key.
+ *
+ * The block counter is left as is and any leftover keystream is discarded.
+ *
+ * @param[in,out] ctx   The context.
+ * @param[in]     nonce The 12-byte nonce.
+ */
+void chacha20_ctx_set_nonce(chacha20_ctx_t *ctx, const uint8_t nonce[12]);
+
+/**
+ * @brief Generates the keystream block at the current counter and advances it.
+ * 
+ * @param[in,out] ctx       The context.
+ * @param[out]    keystream The output buffer to receive the 64-byte keystream.
+ */
+void chacha20_ctx_block(chacha20_ctx_t *ctx, uint8_t keystream[64]);
+
+/**
+ * @brief Encrypts or decrypts data starting at the current block counter.
+ *
+ * The counter advances by one per started 64-byte block, so unused bytes of
+ * a trailing partial block are discarded. Use chacha20_stream_update() to
+ * keep them for the next call instead.
+ * 
+ * @param[in,out] ctx         The context.
+ * @param[in]     data_in     Pointer to the data buffer to encrypt/decrypt.
+ * @param[in]     data_length The length of the data buffer in bytes.
+ * @param[out]    data_out    Pointer to the result (may equal data_in).
+ * @return                    0 on success, 1 if an invalid data_length is provided.
+ */
+int chacha20_ctx_xor(chacha20_ctx_t *ctx, const uint8_t *data_in,
+                     size_t data_length, uint8_t *data_out);
+
+/**
+ * @brief Encrypts or decrypts the next bytes of a stream of arbitrary chunks.
+ *
+ * Keystream bytes left unused by the previous call are consumed first, and
+ * the unused end of the last block is kept in the context, so splitting a
+ * message into chunks of any size yields the same output as one call. The
+ * caller must not exceed 2^32 blocks under one nonce.
+ * 
+ * @param[in,out] ctx         The context, set up by chacha20_ctx_init().
+ * @param[in]     data_in     Pointer to the next chunk to encrypt/decrypt.
+ * @param[in]     data_length The length of the chunk in bytes.
+ * @param[out]    data_out    Pointer to the result (may equal data_in).
+ * @return                    0 on success, 1 if an invalid data_length is provided.
+ */
+int chacha20_stream_update(chacha20_ctx_t *ctx, const uint8_t *data_in,
+                           size_t data_length, uint8_t *data_out);
+
+/**
+ * @brief Positions a context at an arbitrary byte of the keystream.
+ *
+ * The next chacha20_stream_update() call continues from keystream byte
+ * `byte_offset`, counted from the start of block `base_counter`. The cost is
+ * at most one block, however deep the offset.
+ * 
+ * @param[in,out] ctx          The context, set up by chacha20_ctx_init().
+ * @param[in]     base_counter The block counter of keystream byte 0.
+ * @param[in]     byte_offset  The keystream byte to continue from.
+ * @return                     0 on success, 1 if the offset lies past block 2^32 - 1.
+ */
+int chacha20_ctx_seek(chacha20_ctx_t *ctx, uint32_t base_counter,
+                      uint64_t byte_offset);
+
+/**
+ * @brief Encrypts or decrypts bytes [byte_offset, byte_offset + data_length)
+ * of a ChaCha20 stream, for random-access reads of encrypted data.
+ * 
+ * @param[in]  key          The 32-byte (256-bit) symmetric key.
+ * @param[in]  nonce        The 12-byte (96-bit) nonce.
+ * @param[in]  base_counter The block counter of stream byte 0.
+ * @param[in]  byte_offset  The stream position of data_in[0].
+ * @param[in]  data_in      Pointer to the data buffer to encrypt/decrypt.
+ * @param[in]  data_length  The length of the data buffer in bytes.
+ * @param[out] data_out     Pointer to the result (may equal data_in).
+ * @return                  0 on success, 1 if the range needs a block counter past 2^32 - 1.
+ */
+int chacha20_apply_at(const uint8_t key[32], const uint8_t nonce[12],
+                      uint32_t base_counter, uint64_t byte_offset,
+                      const uint8_t *data_in, size_t data_length,
+                      uint8_t *data_out);
+
+/** Default minimum number of bytes given to each thread by chacha20_apply_parallel(). */
+#define CHACHA20_PARALLEL_MIN_CHUNK (1u << 20)
+
+/**
+ * @brief Tuning knobs for chacha20_apply_parallel().
+ */
+typedef struct {
+    unsigned int workers; /**< Maximum threads, caller included; 0 uses the online CPU count */
+    size_t min_chunk;     /**< Minimum bytes per thread; 0 uses CHACHA20_PARALLEL_MIN_CHUNK */
+} chacha20_parallel_opts_t;
+
+/**
+ * @brief Multithreaded chacha20_apply() for large buffers.
+ *
+ * The buffer is split into contiguous counter ranges, one per thread, which
+ * run on a small internal thread pool. Buffers shorter than two chunks of
+ * `min_chunk` bytes are processed on the calling thread. The output is
+ * identical to chacha20_apply().
+ * 
+ * @param[in]  key         The 32-byte (256-bit) symmetric key.
+ * @param[in]  counter     The initial 32-bit block counter.
+ * @param[in]  nonce       The 12-byte (96-bit) nonce.
+ * @param[in]  data_in     Pointer to the data buffer to encrypt/decrypt.
+ * @param[in]  data_length The length of the data buffer in bytes.
+ * @param[out] data_out    Pointer to the result (may equal data_in).
+ * @param[in]  opts        Tuning knobs, or NULL for the defaults.
+ * @return                 0 on success, 1 if an invalid data_length is provided.
+ */
+int chacha20_apply_parallel(const uint8_t key[32], uint32_t counter,
+                            const uint8_t nonce[12], const uint8_t *data_in,
+                            size_t data_length, uint8_t *data_out,
+                            const chacha20_parallel_opts_t *opts);
+
+/**
+ * @brief Reduced-round variants: ChaCha12 and ChaCha8.
+ *
+ * Same interface and state layout as chacha20_block() and chacha20_apply(),
+ * with 12 or 8 rounds instead of 20. Each variant is a separately compiled,
+ * fully unrolled instance of the core. They are meant for non-AEAD uses such
+ * as fingerprints or test data, where the 20-round margin is not needed, and
+ * run on the portable core (the SIMD kernels are 20-round only).
+ */
+int chacha12_block(const uint8_t key[32], uint32_t counter,
+                   const uint8_t nonce[12], uint8_t keystream[64]);
+int chacha12_apply(const uint8_t key[32], uint32_t counter,
+                   const uint8_t nonce[12], const uint8_t *data_in,
+                   size_t data_length, uint8_t *data_out);
+int chacha8_block(const uint8_t key[32], uint32_t counter,
+                  const uint8_t nonce[12], uint8_t keystream[64]);
+int chacha8_apply(const uint8_t key[32], uint32_t counter,
+                  const uint8_t nonce[12], const uint8_t *data_in,
+                  size_t data_length, uint8_t *data_out);
+
 /**
  * @brief Packs four individual bytes into a 32-bit little-endian word.
  * 
@@ -3,9 +3,14 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/uio.h>
+#include "chacha20.h"
 
 /**
  * @brief Encrypts and authenticates data using ChaCha20-Poly1305 AEAD.
+ *
+ * Encryption and authentication run in a single pass over cache-sized
+ * tiles: each tile is MACed right after it is encrypted.
  *  
  * @param[in]  key        The 32-byte (256-bit) symmetric key.
  * @param[in]  iv         The 8-byte initialization vector (nonce part).
@@ -16,7 +21,8 @@
  * @param[in]  aad_len    Length of the AAD in bytes.
  * @param[out] ct         The output buffer for the encrypted data.
  * @param[out] tag        The 16-byte output buffer for the authentication tag.
- * @return                0 on success, non-zero on memory allocation failure.
+ * @return                0 on success, 1 if pt_len exceeds the (2^32 - 1) * 64 bytes
+ *                        the block counter can cover.
  */
 int chacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t iv[8],
                               const uint8_t constant[4], const uint8_t *pt,
@@ -26,6 +32,10 @@ int chacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t iv[8],
 /**
  * @brief Decrypts and verifies data using ChaCha20-Poly1305 AEAD.
  *
+ * Each cache-sized tile is authenticated and decrypted in the same pass.
+ * If the tag does not match, the whole of `pt` is zeroed before returning,
+ * so unauthenticated plaintext is never released.
+ *
  * @param[in]  key        The 32-byte (256-bit) symmetric key.
  * @param[in]  iv         The 8-byte initialization vector (nonce part).
  * @param[in]  constant   The 4-byte constant (nonce part).
@@ -34,12 +44,310 @@ int chacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t iv[8],
  * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
  * @param[in]  aad_len    Length of the AAD in bytes.
  * @param[in]  tag        The 16-byte expected authentication tag to verify.
- * @param[out] pt         The output buffer for the decrypted data. Must be at least `ct_len` bytes.
- * @return                0 on successful verification and decryption, -1 if the tag is invalid, positive on allocation failure.
+ * @param[out] pt         The output buffer for the decrypted data. Must be at least `ct_len` bytes
+ *                        and may equal `ct`.
+ * @return                0 on successful verification and decryption, -1 if the tag is invalid
+ *                        (pt zeroed), 1 if ct_len exceeds the block counter range.
  */
 int chacha20_poly1305_decrypt(const uint8_t key[32],  const uint8_t iv[8],
                               const uint8_t constant[4], const uint8_t *ct,
                               size_t ct_len, const uint8_t *aad, size_t aad_len,
                               const uint8_t tag[16], uint8_t *pt);
 
+/**
+ * @brief chacha20_poly1305_encrypt() with a key expanded ahead of time.
+ *
+ * `key_ctx` is any context set up by chacha20_ctx_init() with the key; its
+ * nonce and counter are ignored and it is only read, so one expanded key
+ * can be shared by many threads.
+ *
+ * @param[in]  key_ctx    The expanded key.
+ * @param[in]  iv         The 8-byte initialization vector (nonce part).
+ * @param[in]  constant   The 4-byte constant (nonce part).
+ * @param[in]  pt         Pointer to the plaintext data.
+ * @param[in]  pt_len     Length of the plaintext in bytes.
+ * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len    Length of the AAD in bytes.
+ * @param[out] ct         The output buffer for the encrypted data.
+ * @param[out] tag        The 16-byte output buffer for the authentication tag.
+ * @return                0 on success, 1 if pt_len exceeds the block counter range.
+ */
+int chacha20_poly1305_encrypt_ctx(const chacha20_ctx_t *key_ctx, const uint8_t iv[8],
+                                  const uint8_t constant[4], const uint8_t *pt,
+                                  size_t pt_len, const uint8_t *aad, size_t aad_len,
+                                  uint8_t *ct, uint8_t tag[16]);
+
+/**
+ * @brief chacha20_poly1305_decrypt() with a key expanded ahead of time.
+ *
+ * @param[in]  key_ctx    The expanded key, as for chacha20_poly1305_encrypt_ctx().
+ * @param[in]  iv         The 8-byte initialization vector (nonce part).
+ * @param[in]  constant   The 4-byte constant (nonce part).
+ * @param[in]  ct         Pointer to the ciphertext data.
+ * @param[in]  ct_len     Length of the ciphertext in bytes.
+ * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len    Length of the AAD in bytes.
+ * @param[in]  tag        The 16-byte expected authentication tag to verify.
+ * @param[out] pt         The output buffer for the decrypted data (may equal `ct`).
+ * @return                0 on success, -1 if the tag is invalid (pt zeroed), 1 if
+ *                        ct_len exceeds the block counter range.
+ */
+int chacha20_poly1305_decrypt_ctx(const chacha20_ctx_t *key_ctx, const uint8_t iv[8],
+                                  const uint8_t constant[4], const uint8_t *ct,
+                                  size_t ct_len, const uint8_t *aad, size_t aad_len,
+                                  const uint8_t tag[16], uint8_t *pt);
+
+/**
+ * @brief Multithreaded chacha20_poly1305_encrypt() for large messages.
+ *
+ * The message is split into contiguous counter ranges, one per thread, as in
+ * chacha20_apply_parallel(). Each thread encrypts its range and evaluates
+ * the Poly1305 polynomial over its own ciphertext from zero; the partial
+ * results are then joined by multiplying with the matching powers of r, so
+ * ciphertext and tag are byte-identical to the serial function. Messages
+ * shorter than two chunks of `min_chunk` bytes run on the calling thread.
+ *
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  iv         The 8-byte initialization vector (nonce part).
+ * @param[in]  constant   The 4-byte constant (nonce part).
+ * @param[in]  pt         Pointer to the plaintext data.
+ * @param[in]  pt_len     Length of the plaintext in bytes.
+ * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len    Length of the AAD in bytes.
+ * @param[out] ct         The output buffer for the encrypted data.
+ * @param[out] tag        The 16-byte output buffer for the authentication tag.
+ * @param[in]  opts       Tuning knobs, or NULL for the defaults.
+ * @return                0 on success, 1 if pt_len exceeds the block counter range.
+ */
+int chacha20_poly1305_encrypt_parallel(const uint8_t key[32], const uint8_t iv[8],
+                                       const uint8_t constant[4], const uint8_t *pt,
+                                       size_t pt_len, const uint8_t *aad, size_t aad_len,
+                                       uint8_t *ct, uint8_t tag[16],
+                                       const chacha20_parallel_opts_t *opts);
+
+/**
+ * @brief Multithreaded chacha20_poly1305_decrypt() for large messages.
+ *
+ * Threads authenticate and decrypt their ranges in one pass; the joined tag
+ * is checked at the end and `pt` is zeroed if it does not match.
+ *
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  iv         The 8-byte initialization vector (nonce part).
+ * @param[in]  constant   The 4-byte constant (nonce part).
+ * @param[in]  ct         Pointer to the ciphertext data.
+ * @param[in]  ct_len     Length of the ciphertext in bytes.
+ * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len    Length of the AAD in bytes.
+ * @param[in]  tag        The 16-byte expected authentication tag to verify.
+ * @param[out] pt         The output buffer for the decrypted data (may equal `ct`).
+ * @param[in]  opts       Tuning knobs, or NULL for the defaults.
+ * @return                0 on successful verification and decryption, -1 if the tag is invalid
+ *                        (pt zeroed), 1 if ct_len exceeds the block counter range.
+ */
+int chacha20_poly1305_decrypt_parallel(const uint8_t key[32], const uint8_t iv[8],
+                                       const uint8_t constant[4], const uint8_t *ct,
+                                       size_t ct_len, const uint8_t *aad, size_t aad_len,
+                                       const uint8_t tag[16], uint8_t *pt,
+                                       const chacha20_parallel_opts_t *opts);
+
+/**
+ * @brief Scatter/gather variant of chacha20_poly1305_encrypt().
+ *
+ * The AAD, plaintext and ciphertext are each given as an array of buffers
+ * and are treated as their concatenation. The plaintext and ciphertext
+ * vectors may be split at different offsets; keystream and MAC state carry
+ * across fragment boundaries, so nothing is copied into a bounce buffer.
+ *
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  iv         The 8-byte initialization vector (nonce part).
+ * @param[in]  constant   The 4-byte constant (nonce part).
+ * @param[in]  aad        The AAD fragments.
+ * @param[in]  aad_cnt    Number of AAD fragments.
+ * @param[in]  pt         The plaintext fragments.
+ * @param[in]  pt_cnt     Number of plaintext fragments.
+ * @param[out] ct         The output fragments; the first pt-total bytes are written.
+ * @param[in]  ct_cnt     Number of output fragments.
+ * @param[out] tag        The 16-byte output buffer for the authentication tag.
+ * @return                0 on success, 1 if the output is shorter than the
+ *                        plaintext or the plaintext exceeds the block counter range.
+ */
+int chacha20_poly1305_encryptv(const uint8_t key[32], const uint8_t iv[8],
+                               const uint8_t constant[4],
+                               const struct iovec *aad, size_t aad_cnt,
+                               const struct iovec *pt, size_t pt_cnt,
+                               const struct iovec *ct, size_t ct_cnt,
+                               uint8_t tag[16]);
+
+/**
+ * @brief Scatter/gather variant of chacha20_poly1305_decrypt().
+ *
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  iv         The 8-byte initialization vector (nonce part).
+ * @param[in]  constant   The 4-byte constant (nonce part).
+ * @param[in]  aad        The AAD fragments.
+ * @param[in]  aad_cnt    Number of AAD fragments.
+ * @param[in]  ct         The ciphertext fragments.
+ * @param[in]  ct_cnt     Number of ciphertext fragments.
+ * @param[in]  tag        The 16-byte expected authentication tag to verify.
+ * @param[out] pt         The output fragments; the first ct-total bytes are written.
+ * @param[in]  pt_cnt     Number of output fragments.
+ * @return                0 on successful verification and decryption, -1 if the tag is invalid
+ *                        (written output zeroed), 1 if the output is too short or the
+ *                        ciphertext exceeds the block counter range.
+ */
+int chacha20_poly1305_decryptv(const uint8_t key[32], const uint8_t iv[8],
+                               const uint8_t constant[4],
+                               const struct iovec *aad, size_t aad_cnt,
+                               const struct iovec *ct, size_t ct_cnt,
+                               const uint8_t tag[16],
+                               const struct iovec *pt, size_t pt_cnt);
+
+/**
+ * @brief One packet of a chacha20_poly1305_encrypt_batch() call.
+ */
+typedef struct {
+    const uint8_t *iv;      /**< The 8-byte initialization vector (nonce part) */
+    const uint8_t *aad;     /**< The Additional Authenticated Data */
+    size_t aad_len;         /**< Length of the AAD in bytes */
+    const uint8_t *pt;      /**< The plaintext */
+    size_t pt_len;          /**< Length of the plaintext in bytes */
+    uint8_t *ct;            /**< Output buffer for pt_len bytes of ciphertext */
+    uint8_t *tag;           /**< Output buffer for the 16-byte tag */
+} chacha20_poly1305_packet_t;
+
+/**
+ * @brief Encrypts and authenticates many independent packets under one key.
+ *
+ * Each packet gives the same result as chacha20_poly1305_encrypt() with its
+ * own IV. Keystream blocks of different packets, including the block that
+ * yields each packet's Poly1305 key, are computed side by side in the lanes
+ * of the multi-state SIMD kernels, so short packets no longer leave most of
+ * a vector unused. Packets of 1 KiB or more are sealed one at a time.
+ *
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  constant   The 4-byte constant (nonce part) shared by all packets.
+ * @param[in]  packets    The packets; ct and tag are written for each.
+ * @param[in]  count      Number of packets.
+ * @return                0 on success, 1 if a packet exceeds the block counter
+ *                        range (nothing is written in that case).
+ */
+int chacha20_poly1305_encrypt_batch(const uint8_t key[32],
+                                    const uint8_t constant[4],
+                                    const chacha20_poly1305_packet_t *packets,
+                                    size_t count);
+
+/**
+ * @brief AEAD session for a sequence of records under one key.
+ *
+ * The key and constant are expanded once at session_init. Record n is
+ * sealed with IV n (64-bit little-endian), so the same records can also be
+ * opened with chacha20_poly1305_decrypt() given that IV. Use one session per
+ * direction: seal and open draw from the same sequence number.
+ */
+typedef struct {
+    chacha20_ctx_t ctx;     /**< Expanded key and nonce of the current record */
+    uint8_t nonce[12];      /**< constant | IV of the current record */
+    uint64_t seq;           /**< Sequence number (IV) of the next record */
+    int exhausted;          /**< Set once IV 2^64 - 1 has been used */
+} chacha20_poly1305_session_t;
+
+/**
+ * @brief Starts a session at sequence number 0.
+ *
+ * @param[out] session    The session.
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  constant   The 4-byte constant (nonce part) of every record.
+ */
+void chacha20_poly1305_session_init(chacha20_poly1305_session_t *session,
+                                    const uint8_t key[32],
+                                    const uint8_t constant[4]);
+
+/**
+ * @brief Seals the next record of a session and advances its IV.
+ *
+ * @param[in,out] session The session.
+ * @param[in]     pt      Pointer to the plaintext data.
+ * @param[in]     pt_len  Length of the plaintext in bytes.
+ * @param[in]     aad     Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]     aad_len Length of the AAD in bytes.
+ * @param[out]    ct      The output buffer for the encrypted data.
+ * @param[out]    tag     The 16-byte output buffer for the authentication tag.
+ * @return                0 on success, 1 if every IV has been used (the IV
+ *                        never wraps) or pt_len exceeds the block counter range.
+ */
+int chacha20_poly1305_seal(chacha20_poly1305_session_t *session,
+                           const uint8_t *pt, size_t pt_len,
+                           const uint8_t *aad, size_t aad_len,
+                           uint8_t *ct, uint8_t tag[16]);
+
+/**
+ * @brief Opens the next record of a session.
+ *
+ * The IV only advances when the record authenticates, so a forged record
+ * does not desynchronize the session.
+ *
+ * @param[in,out] session The session.
+ * @param[in]     ct      Pointer to the ciphertext data.
+ * @param[in]     ct_len  Length of the ciphertext in bytes.
+ * @param[in]     aad     Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]     aad_len Length of the AAD in bytes.
+ * @param[in]     tag     The 16-byte expected authentication tag to verify.
+ * @param[out]    pt      The output buffer for the decrypted data (may equal `ct`).
+ * @return                0 on success, -1 if the tag is invalid (pt zeroed), 1 if
+ *                        every IV has been used or ct_len exceeds the block counter range.
+ */
+int chacha20_poly1305_open(chacha20_poly1305_session_t *session,
+                           const uint8_t *ct, size_t ct_len,
+                           const uint8_t *aad, size_t aad_len,
+                           const uint8_t tag[16], uint8_t *pt);
+
+/**
+ * @brief Erases the expanded key held by a session.
+ *
+ * @param[in,out] session The session.
+ */
+void chacha20_poly1305_session_wipe(chacha20_poly1305_session_t *session);
+
+/**
+ * @brief Encrypts and authenticates data using XChaCha20-Poly1305 AEAD.
+ *
+ * The first 16 nonce bytes and the key go through hchacha20() to derive a
+ * subkey, which then encrypts with chacha20_poly1305_encrypt() using a zero
+ * constant and the last 8 nonce bytes as IV. The 192-bit nonce is large
+ * enough to be picked at random for every message.
+ *  
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  nonce      The 24-byte (192-bit) nonce.
+ * @param[in]  pt         Pointer to the plaintext data.
+ * @param[in]  pt_len     Length of the plaintext in bytes.
+ * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len    Length of the AAD in bytes.
+ * @param[out] ct         The output buffer for the encrypted data.
+ * @param[out] tag        The 16-byte output buffer for the authentication tag.
+ * @return                0 on success, 1 if pt_len exceeds the block counter range.
+ */
+int xchacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t nonce[24],
+                               const uint8_t *pt, size_t pt_len,
+                               const uint8_t *aad, size_t aad_len,
+                               uint8_t *ct, uint8_t tag[16]);
+
+/**
+ * @brief Decrypts and verifies data using XChaCha20-Poly1305 AEAD.
+ *
+ * @param[in]  key        The 32-byte (256-bit) symmetric key.
+ * @param[in]  nonce      The 24-byte (192-bit) nonce.
+ * @param[in]  ct         Pointer to the ciphertext data.
+ * @param[in]  ct_len     Length of the ciphertext in bytes.
+ * @param[in]  aad        Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len    Length of the AAD in bytes.
+ * @param[in]  tag        The 16-byte expected authentication tag to verify.
+ * @param[out] pt         The output buffer for the decrypted data. Must be at least `ct_len` bytes.
+ * @return                0 on successful verification and decryption, -1 if the tag is invalid
+ *                        (pt zeroed), 1 if ct_len exceeds the block counter range.
+ */
+int xchacha20_poly1305_decrypt(const uint8_t key[32], const uint8_t nonce[24],
+                               const uint8_t *ct, size_t ct_len,
+                               const uint8_t *aad, size_t aad_len,
+                               const uint8_t tag[16], uint8_t *pt);
+
 #endif /* __CHACHA20_POLY1305__ */
\ No newline at end of file
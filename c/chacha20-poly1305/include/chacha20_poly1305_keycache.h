@@ -0,0 +1,140 @@
+#ifndef __CHACHA20_POLY1305_KEYCACHE__
+#define __CHACHA20_POLY1305_KEYCACHE__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "chacha20.h"
+
+/**
+ * @brief Fetches the raw key for a key ID on a cache miss.
+ *
+ * Called without any cache lock held, so it may block (e.g. on a key store).
+ *
+ * @param[in]  arg    The opaque pointer given to chacha20_keycache_create().
+ * @param[in]  key_id The key ID.
+ * @param[out] key    The 32-byte key.
+ * @return            0 on success, non-zero if the key ID is unknown.
+ */
+typedef int (*chacha20_keycache_load_fn)(void *arg, uint64_t key_id, uint8_t key[32]);
+
+/** Opaque bounded cache of expanded keys. */
+typedef struct chacha20_keycache chacha20_keycache_t;
+
+/**
+ * @brief Cache activity since creation, summed over all shards.
+ */
+typedef struct {
+    uint64_t hits;          /**< Lookups served from the cache */
+    uint64_t misses;        /**< Lookups that had to call the loader */
+    uint64_t evictions;     /**< Entries dropped to make room */
+    size_t entries;         /**< Entries currently cached */
+    size_t capacity;        /**< Most entries the cache holds */
+} chacha20_keycache_stats_t;
+
+/**
+ * @brief Creates a cache of expanded ChaCha20 keys indexed by key ID.
+ *
+ * Key IDs are hashed over independent shards, each with its own lock, its
+ * own share of the capacity and its own CLOCK (second-chance) eviction
+ * hand, so lookups for different keys rarely contend. Entries hold the
+ * expanded 16-word state (64 bytes), so the working set is about 80 bytes
+ * per key. Evicted and invalidated entries are wiped.
+ *
+ * @param[in] capacity Most keys held (rounded up to fill every shard equally).
+ * @param[in] shards   Number of shards, rounded up to a power of two (0 for 16).
+ * @param[in] load     Loader called on a miss.
+ * @param[in] arg      Opaque pointer passed to the loader.
+ * @return             The cache, or NULL if capacity is 0 or memory ran out.
+ */
+chacha20_keycache_t *chacha20_keycache_create(size_t capacity, size_t shards,
+                                              chacha20_keycache_load_fn load,
+                                              void *arg);
+
+/**
+ * @brief Wipes every cached key and frees the cache.
+ *
+ * @param[in] cache The cache (may be NULL).
+ */
+void chacha20_keycache_destroy(chacha20_keycache_t *cache);
+
+/**
+ * @brief Looks up the expanded key for a key ID, loading it on a miss.
+ *
+ * The entry is copied out, so the context stays valid after the entry is
+ * evicted. It is ready for chacha20_poly1305_encrypt_ctx() or, once given a
+ * nonce with chacha20_ctx_set_nonce(), for the chacha20_ctx_* calls.
+ *
+ * @param[in]  cache  The cache.
+ * @param[in]  key_id The key ID.
+ * @param[out] ctx    The expanded key, with a zero nonce and counter.
+ * @return            0 on success, 1 if the loader failed.
+ */
+int chacha20_keycache_get(chacha20_keycache_t *cache, uint64_t key_id,
+                          chacha20_ctx_t *ctx);
+
+/**
+ * @brief Drops and wipes the entry for a key ID, e.g. after key rotation.
+ *
+ * A load of the key already in flight on another thread still returns the
+ * key it read to its caller but is not cached, so the next lookup calls
+ * the loader again.
+ *
+ * @param[in] cache  The cache.
+ * @param[in] key_id The key ID.
+ */
+void chacha20_keycache_invalidate(chacha20_keycache_t *cache, uint64_t key_id);
+
+/**
+ * @brief Reads the hit, miss and eviction counters.
+ *
+ * @param[in]  cache The cache.
+ * @param[out] stats The counters.
+ */
+void chacha20_keycache_stats(chacha20_keycache_t *cache,
+                             chacha20_keycache_stats_t *stats);
+
+/**
+ * @brief chacha20_poly1305_encrypt() under the cached key of a key ID.
+ *
+ * @param[in]  cache    The cache.
+ * @param[in]  key_id   The key ID.
+ * @param[in]  iv       The 8-byte initialization vector (nonce part).
+ * @param[in]  constant The 4-byte constant (nonce part).
+ * @param[in]  pt       Pointer to the plaintext data.
+ * @param[in]  pt_len   Length of the plaintext in bytes.
+ * @param[in]  aad      Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len  Length of the AAD in bytes.
+ * @param[out] ct       The output buffer for the encrypted data.
+ * @param[out] tag      The 16-byte output buffer for the authentication tag.
+ * @return              0 on success, 1 if the key could not be loaded or pt_len
+ *                      exceeds the block counter range.
+ */
+int chacha20_keycache_encrypt(chacha20_keycache_t *cache, uint64_t key_id,
+                              const uint8_t iv[8], const uint8_t constant[4],
+                              const uint8_t *pt, size_t pt_len,
+                              const uint8_t *aad, size_t aad_len,
+                              uint8_t *ct, uint8_t tag[16]);
+
+/**
+ * @brief chacha20_poly1305_decrypt() under the cached key of a key ID.
+ *
+ * @param[in]  cache    The cache.
+ * @param[in]  key_id   The key ID.
+ * @param[in]  iv       The 8-byte initialization vector (nonce part).
+ * @param[in]  constant The 4-byte constant (nonce part).
+ * @param[in]  ct       Pointer to the ciphertext data.
+ * @param[in]  ct_len   Length of the ciphertext in bytes.
+ * @param[in]  aad      Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]  aad_len  Length of the AAD in bytes.
+ * @param[in]  tag      The 16-byte expected authentication tag to verify.
+ * @param[out] pt       The output buffer for the decrypted data (may equal `ct`).
+ * @return              0 on success, -1 if the tag is invalid (pt zeroed), 1 if the
+ *                      key could not be loaded or ct_len exceeds the block counter range.
+ */
+int chacha20_keycache_decrypt(chacha20_keycache_t *cache, uint64_t key_id,
+                              const uint8_t iv[8], const uint8_t constant[4],
+                              const uint8_t *ct, size_t ct_len,
+                              const uint8_t *aad, size_t aad_len,
+                              const uint8_t tag[16], uint8_t *pt);
+
+#endif /* __CHACHA20_POLY1305_KEYCACHE__ */
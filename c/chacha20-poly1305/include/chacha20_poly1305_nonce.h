@@ -0,0 +1,106 @@
+#ifndef __CHACHA20_POLY1305_NONCE__
+#define __CHACHA20_POLY1305_NONCE__
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/** IVs a pooled allocator reserves at a time when no block size is given. */
+#define CHACHA20_NONCE_POOL_BLOCK 65536
+
+/**
+ * @brief Shared source of IV ranges for threads that come and go.
+ *
+ * All allocators drawing from a pool use its constant; each takes a private
+ * range of IVs with one atomic compare-and-swap and hands them out with no
+ * further synchronization. The last range runs through IV 2^64 - 1, so it
+ * may be shorter or one IV longer than the others.
+ */
+typedef struct {
+    _Atomic uint64_t next;  /**< First IV of the next unreserved range; 2^64 - 1 once exhausted */
+    uint64_t block_ivs;     /**< IVs per reserved range */
+    uint8_t constant[4];    /**< Constant shared by every range of the pool */
+} chacha20_nonce_pool_t;
+
+/**
+ * @brief Per-thread nonce allocator for one key.
+ *
+ * An allocator belongs to a single thread (keep it in thread-local storage
+ * or on the worker's stack); only the pool behind it is shared. Nonces are
+ * the pair (constant, IV) of chacha20_poly1305_encrypt(), with the IV
+ * increasing monotonically within each range. They are unique under a key
+ * as long as fixed worker IDs and pool constants are kept disjoint.
+ */
+typedef struct {
+    chacha20_nonce_pool_t *pool;    /**< Shared pool, or NULL for a fixed worker */
+    uint8_t constant[4];            /**< Constant of every nonce handed out */
+    uint64_t next;                  /**< Next IV to hand out */
+    uint64_t last;                  /**< Last IV of the current range */
+    int has_range;                  /**< Whether next..last is still available */
+} chacha20_nonce_t;
+
+/**
+ * @brief Initializes a pool.
+ *
+ * @param[out] pool      The pool.
+ * @param[in]  constant  The 4-byte constant of the pool's nonces.
+ * @param[in]  block_ivs IVs per reservation, or 0 for CHACHA20_NONCE_POOL_BLOCK.
+ */
+void chacha20_nonce_pool_init(chacha20_nonce_pool_t *pool, const uint8_t constant[4],
+                              uint64_t block_ivs);
+
+/**
+ * @brief Initializes an allocator for a fixed worker.
+ *
+ * The constant is the worker ID (32-bit little-endian) and the IV runs from
+ * 0 through 2^64 - 1, so no shared state is touched at all.
+ *
+ * @param[out] n         The allocator.
+ * @param[in]  worker_id The worker ID, unique among the key's senders.
+ */
+void chacha20_nonce_init_worker(chacha20_nonce_t *n, uint32_t worker_id);
+
+/**
+ * @brief Initializes an allocator drawing IV ranges from a pool.
+ *
+ * IVs left in the range when the allocator is dropped are never reused.
+ *
+ * @param[out] n    The allocator.
+ * @param[in]  pool The pool, which must outlive the allocator.
+ */
+void chacha20_nonce_init_pooled(chacha20_nonce_t *n, chacha20_nonce_pool_t *pool);
+
+/**
+ * @brief Hands out the next nonce.
+ *
+ * @param[in,out] n        The allocator.
+ * @param[out]    constant The 4-byte constant of the nonce.
+ * @param[out]    iv       The 8-byte IV of the nonce.
+ * @return                 0 on success, 1 if the allocator (or its pool) is exhausted.
+ */
+int chacha20_nonce_next(chacha20_nonce_t *n, uint8_t constant[4], uint8_t iv[8]);
+
+/**
+ * @brief Seals a message under the next nonce of an allocator.
+ *
+ * The nonce used is returned so it can be sent along with the ciphertext.
+ *
+ * @param[in,out] n        The allocator.
+ * @param[in]     key      The 32-byte (256-bit) symmetric key.
+ * @param[out]    constant The 4-byte constant of the nonce used.
+ * @param[out]    iv       The 8-byte IV of the nonce used.
+ * @param[in]     pt       The plaintext input buffer.
+ * @param[in]     pt_len   The length of the plaintext.
+ * @param[in]     aad      The additional authenticated data buffer.
+ * @param[in]     aad_len  The length of the AAD.
+ * @param[out]    ct       The ciphertext output buffer (same size as plaintext).
+ * @param[out]    tag      The 16-byte authentication tag output buffer.
+ * @return                 0 on success, 1 if no nonce is left or pt_len is too large.
+ */
+int chacha20_nonce_encrypt(chacha20_nonce_t *n, const uint8_t key[32],
+                           uint8_t constant[4], uint8_t iv[8],
+                           const uint8_t *pt, size_t pt_len,
+                           const uint8_t *aad, size_t aad_len,
+                           uint8_t *ct, uint8_t tag[16]);
+
+#endif /* __CHACHA20_POLY1305_NONCE__ */
@@ -0,0 +1,92 @@
+#ifndef __CHACHA20_POLY1305_PRECOMP__
+#define __CHACHA20_POLY1305_PRECOMP__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "chacha20_poly1305.h"
+
+/** Opaque background keystream generator for one session. */
+typedef struct chacha20_poly1305_precomp chacha20_poly1305_precomp_t;
+
+/**
+ * @brief How the records of a precomputing session were sealed.
+ */
+typedef struct {
+    uint64_t precomputed;   /**< Records sealed from the ring */
+    uint64_t inline_seals;  /**< Records sealed inline (ring empty or record too long) */
+    uint64_t discarded;     /**< Ring slots dropped because the session had moved past them */
+} chacha20_poly1305_precomp_stats_t;
+
+/**
+ * @brief Starts precomputing keystream for the next records of a session.
+ *
+ * A helper thread fills a single-producer, single-consumer ring with the
+ * Poly1305 key block and data keystream of the session's next `records`
+ * IVs, up to `max_record` bytes each, so chacha20_poly1305_precomp_seal()
+ * only has to XOR and MAC. The seal path takes no lock; the helper parks
+ * when the ring is full and is woken once half of it has been used.
+ *
+ * @param[in] session    The session, which keeps its key and sequence number.
+ * @param[in] records    Ring size in records (at least 2).
+ * @param[in] max_record Largest plaintext precomputed for, in bytes.
+ * @return               The generator, or NULL if the arguments are invalid or no
+ *                       memory or thread was available.
+ */
+chacha20_poly1305_precomp_t *chacha20_poly1305_precomp_start(
+    const chacha20_poly1305_session_t *session, size_t records, size_t max_record);
+
+/**
+ * @brief Seals the next record of a session, using precomputed keystream.
+ *
+ * Gives the same result as chacha20_poly1305_seal() on the session. Slots
+ * for IVs the session has already used (e.g. through direct calls to
+ * chacha20_poly1305_seal()) are wiped and skipped; when no slot is ready,
+ * or the record is longer than `max_record`, the record is sealed inline.
+ * The keystream a record used is wiped from the ring once it is sealed.
+ * Only the thread that owns the session may call this.
+ *
+ * @param[in,out] pc      The generator started for this session.
+ * @param[in,out] session The session.
+ * @param[in]     pt      Pointer to the plaintext data.
+ * @param[in]     pt_len  Length of the plaintext in bytes.
+ * @param[in]     aad     Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]     aad_len Length of the AAD in bytes.
+ * @param[out]    ct      The output buffer for the encrypted data.
+ * @param[out]    tag     The 16-byte output buffer for the authentication tag.
+ * @return                0 on success, 1 if every IV has been used or pt_len
+ *                        exceeds the block counter range.
+ */
+int chacha20_poly1305_precomp_seal(chacha20_poly1305_precomp_t *pc,
+                                   chacha20_poly1305_session_t *session,
+                                   const uint8_t *pt, size_t pt_len,
+                                   const uint8_t *aad, size_t aad_len,
+                                   uint8_t *ct, uint8_t tag[16]);
+
+/**
+ * @brief Counts the records whose keystream is ready in the ring.
+ *
+ * Slots for IVs the session has already used count until a seal skips them.
+ * Only the thread that owns the session may call this.
+ *
+ * @param[in] pc The generator.
+ * @return       Slots ready, at most the ring size.
+ */
+size_t chacha20_poly1305_precomp_ready(const chacha20_poly1305_precomp_t *pc);
+
+/**
+ * @brief Reads how records have been sealed so far.
+ *
+ * @param[in]  pc    The generator.
+ * @param[out] stats The counters.
+ */
+void chacha20_poly1305_precomp_stats(const chacha20_poly1305_precomp_t *pc,
+                                     chacha20_poly1305_precomp_stats_t *stats);
+
+/**
+ * @brief Stops the helper thread, wipes the ring and frees the generator.
+ *
+ * @param[in] pc The generator (may be NULL).
+ */
+void chacha20_poly1305_precomp_stop(chacha20_poly1305_precomp_t *pc);
+
+#endif /* __CHACHA20_POLY1305_PRECOMP__ */
@@ -0,0 +1,86 @@
+#ifndef __CHACHA20_POLY1305_STREAM__
+#define __CHACHA20_POLY1305_STREAM__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Size of the random stream header written before the first segment. */
+#define CHACHA20_STREAM_HEADER_BYTES 16
+/** Plaintext bytes in every segment except the final one. */
+#define CHACHA20_STREAM_SEGMENT_BYTES 65536
+/** Bytes each segment grows by when sealed (its Poly1305 tag). */
+#define CHACHA20_STREAM_TAG_BYTES 16
+
+/**
+ * @brief State of one encrypting (push) or decrypting (pull) stream.
+ *
+ * The stream splits data into fixed-size segments, each sealed with
+ * chacha20_poly1305_encrypt(). The random header and the key go through
+ * hchacha20() to give a per-stream subkey; segment i then uses IV i (64-bit
+ * little-endian) with a zero constant, so segments cannot be reordered, and
+ * one byte of AAD flags the final segment, so the stream cannot be truncated
+ * or extended. Memory use is constant whatever the stream size.
+ */
+typedef struct {
+    uint8_t key[32];        /**< The per-stream subkey */
+    uint64_t counter;       /**< Index of the next segment */
+    int finished;           /**< Set once the final segment has passed */
+} chacha20_stream_state_t;
+
+/**
+ * @brief Starts an encrypting stream.
+ *
+ * @param[out] st     The stream state.
+ * @param[in]  key    The 32-byte (256-bit) symmetric key.
+ * @param[out] header The random header, to be sent ahead of the segments.
+ * @return            0 on success, non-zero if no random header could be drawn.
+ */
+int chacha20_stream_init_push(chacha20_stream_state_t *st, const uint8_t key[32],
+                              uint8_t header[CHACHA20_STREAM_HEADER_BYTES]);
+
+/**
+ * @brief Seals the next segment of an encrypting stream.
+ *
+ * Every segment but the last carries exactly CHACHA20_STREAM_SEGMENT_BYTES
+ * of plaintext. A shorter segment (possibly empty) is the final one and
+ * closes the stream; the subkey is wiped afterwards.
+ *
+ * @param[in,out] st     The stream state.
+ * @param[in]     in     The plaintext of the segment.
+ * @param[in]     in_len Its length, at most CHACHA20_STREAM_SEGMENT_BYTES.
+ * @param[out]    out    The sealed segment: in_len + CHACHA20_STREAM_TAG_BYTES bytes.
+ * @return               0 on success, 1 if in_len is too large or the stream is closed.
+ */
+int chacha20_stream_push(chacha20_stream_state_t *st, const uint8_t *in,
+                         size_t in_len, uint8_t *out);
+
+/**
+ * @brief Starts a decrypting stream.
+ *
+ * @param[out] st     The stream state.
+ * @param[in]  key    The 32-byte (256-bit) symmetric key.
+ * @param[in]  header The header produced by chacha20_stream_init_push().
+ */
+void chacha20_stream_init_pull(chacha20_stream_state_t *st, const uint8_t key[32],
+                               const uint8_t header[CHACHA20_STREAM_HEADER_BYTES]);
+
+/**
+ * @brief Verifies and opens the next segment of a decrypting stream.
+ *
+ * A sealed segment shorter than CHACHA20_STREAM_SEGMENT_BYTES +
+ * CHACHA20_STREAM_TAG_BYTES is taken as the final one. The stream is only
+ * complete once `final` has been reported; input ending earlier has been
+ * truncated.
+ *
+ * @param[in,out] st     The stream state.
+ * @param[in]     in     The sealed segment.
+ * @param[in]     in_len Its length, including the tag.
+ * @param[out]    out    The plaintext: in_len - CHACHA20_STREAM_TAG_BYTES bytes.
+ * @param[out]    final  Set to 1 if this was the final segment, 0 otherwise.
+ * @return               0 on success, -1 if the segment does not authenticate
+ *                       (out zeroed), 1 if in_len is invalid or the stream is closed.
+ */
+int chacha20_stream_pull(chacha20_stream_state_t *st, const uint8_t *in,
+                         size_t in_len, uint8_t *out, int *final);
+
+#endif /* __CHACHA20_POLY1305_STREAM__ */
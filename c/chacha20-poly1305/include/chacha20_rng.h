@@ -0,0 +1,34 @@
+#ifndef __CHACHA20_RNG__
+#define __CHACHA20_RNG__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Fills a buffer with cryptographically secure random bytes.
+ *
+ * Bytes come from a per-thread ChaCha20 generator seeded by the operating
+ * system. Keystream is produced 1 KiB at a time through the multi-block
+ * kernel. Each refill rekeys the generator from its own output and erases
+ * the previous key (fast key erasure), and bytes are wiped from the buffer
+ * as soon as they are handed out, so a later memory disclosure does not
+ * reveal earlier outputs. The hot path takes no lock. The generator reseeds
+ * itself after a fork and periodically from the operating system.
+ * 
+ * @param[out] buf The output buffer.
+ * @param[in]  len The number of random bytes to write.
+ * @return         0 on success, non-zero if the operating system entropy source failed.
+ */
+int chacha20_rng_bytes(void *buf, size_t len);
+
+/**
+ * @brief Returns a cryptographically secure random 64-bit integer.
+ *
+ * Same generator as chacha20_rng_bytes(). The process is aborted if the
+ * operating system entropy source fails, since no safe value can be returned.
+ * 
+ * @return A uniformly distributed 64-bit value.
+ */
+uint64_t chacha20_rng_u64(void);
+
+#endif /* __CHACHA20_RNG__ */
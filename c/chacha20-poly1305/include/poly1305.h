@@ -4,6 +4,56 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/**
+ * @brief Incremental Poly1305 state.
+ *
+ * Fixed-size: the accumulator and r are held in 44-bit limbs where the
+ * compiler provides 128-bit products, and in 26-bit limbs otherwise.
+ */
+typedef struct {
+#if defined(__SIZEOF_INT128__)
+    uint64_t r[3];      /**< Clamped r, 44/44/42-bit limbs */
+    uint64_t h[3];      /**< Accumulator, partially reduced */
+    uint64_t pad[2];    /**< s, the second half of the key */
+    uint32_t r_pow[4][5]; /**< r^1..r^4 in 26-bit limbs, for the SIMD path */
+    int r_pow_ready;    /**< Whether r_pow holds the powers of this key's r */
+#else
+    uint32_t r[5];      /**< Clamped r, 26-bit limbs */
+    uint32_t h[5];      /**< Accumulator, partially reduced */
+    uint32_t pad[4];    /**< s, the second half of the key */
+#endif
+    uint8_t buffer[16]; /**< Bytes of an incomplete block */
+    size_t leftover;    /**< Number of bytes held in buffer */
+} poly1305_state_t;
+
+/**
+ * @brief Starts an incremental Poly1305 computation.
+ * 
+ * @param[out] st  The state to initialize.
+ * @param[in]  key The 32-byte one-time Poly1305 key.
+ */
+void poly1305_init(poly1305_state_t *st, const uint8_t key[32]);
+
+/**
+ * @brief Absorbs the next bytes of the message.
+ *
+ * Data may be split at any byte boundary: partial 16-byte blocks are kept
+ * in the state until completed by a later call or by poly1305_final().
+ * 
+ * @param[in,out] st   The state.
+ * @param[in]     data Pointer to the next message bytes.
+ * @param[in]     len  The number of bytes.
+ */
+void poly1305_update(poly1305_state_t *st, const uint8_t *data, size_t len);
+
+/**
+ * @brief Absorbs any buffered partial block and produces the tag.
+ * 
+ * @param[in,out] st  The state; it must be re-initialized before reuse.
+ * @param[out]    tag The 16-byte output buffer to receive the computed MAC.
+ */
+void poly1305_final(poly1305_state_t *st, uint8_t tag[16]);
+
 /**
  * @brief Computes the Poly1305 Message Authentication Code (MAC) for a given message.
  * 
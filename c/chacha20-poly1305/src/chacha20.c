@@ -1,5 +1,8 @@
 #include "chacha20.h"
+#include <stdatomic.h>
 #include <string.h>
+#include "chacha20_simd.h"
+#include "cpu_features.h"
 
 /**
  * @brief Initializes the 16-word ChaCha20 state matrix.
@@ -37,17 +40,44 @@ static void init_state(uint32_t state[16], const uint8_t key[32],
     state[15] = be_to_le(nonce[8], nonce[9], nonce[10], nonce[11]);
 }
 
-int chacha20_block(const uint8_t key[32], uint32_t counter,
-                   const uint8_t nonce[12], uint8_t keystream[64])
+/* Unaligned-safe little-endian word access; memcpy compiles to a plain mov. */
+static inline uint32_t load32_le(const uint8_t *p)
 {
-    uint32_t state[16];
-    uint32_t w_state[16];
+    uint32_t w;
 
-    init_state(state, key, nonce, counter);
-    memcpy(w_state, state, 16 * sizeof(uint32_t));
+    memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap32(w);
+#endif
+
+    return w;
+}
+
+static inline void store32_le(uint8_t *p, uint32_t w)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap32(w);
+#endif
+    memcpy(p, &w, sizeof(w));
+}
+
+/* Generic bodies, specialized per round count by CHACHA_DEFINE_CORE below. */
+#define CHACHA_INLINE static inline __attribute__((always_inline))
 
-    /* 20 rounds (10 column rounds, 10 diagonal rounds) */
-    for (int i = 0; i < 10; i++) {
+/**
+ * @brief Runs `rounds` ChaCha rounds on a working copy of the state.
+ *
+ * Only ever called with a constant `rounds`, so each instance compiles to a
+ * fully unrolled round sequence with no branch on the round count.
+ *
+ * @param w_state The 16-word working state, permuted in place.
+ * @param rounds  The number of rounds (8, 12 or 20).
+ */
+CHACHA_INLINE void chacha_rounds(uint32_t w_state[16], const int rounds)
+{
+    /* rounds / 2 double rounds (column rounds, then diagonal rounds) */
+    _Pragma("GCC unroll 10")
+    for (int i = 0; i < rounds / 2; i++) {
         /* Column rounds */
         quarter_round(&w_state[0], &w_state[4], &w_state[8], &w_state[12]);
         quarter_round(&w_state[1], &w_state[5], &w_state[9], &w_state[13]);
@@ -60,47 +90,469 @@ int chacha20_block(const uint8_t key[32], uint32_t counter,
         quarter_round(&w_state[2], &w_state[7], &w_state[8], &w_state[13]);
         quarter_round(&w_state[3], &w_state[4], &w_state[9], &w_state[14]);
     }
+}
+
+/**
+ * @brief Computes one keystream block from an expanded state and serializes
+ * it, including the feed-forward of the input state.
+ *
+ * @param state     The 16-word input state.
+ * @param keystream The output buffer to receive the 64-byte keystream.
+ * @param rounds    The number of rounds.
+ */
+CHACHA_INLINE void chacha_block_state(const uint32_t state[16],
+                                      uint8_t keystream[64], const int rounds)
+{
+    uint32_t w_state[16];
+
+    memcpy(w_state, state, 16 * sizeof(uint32_t));
+    chacha_rounds(w_state, rounds);
 
-    /* Add original state to working state and serialize */
     for (int i = 0; i < 16; i++) {
-        uint32_t final_word = state[i] + w_state[i];
-        
-        keystream[i * 4 + 0] = final_word & 0xff;
-        keystream[i * 4 + 1] = (final_word >> 8) & 0xff;
-        keystream[i * 4 + 2] = (final_word >> 16) & 0xff;
-        keystream[i * 4 + 3] = (final_word >> 24) & 0xff;
+        store32_le(keystream + 4 * i, state[i] + w_state[i]);
+    }
+}
+
+/**
+ * @brief Portable kernel, used when no SIMD unit is available.
+ *
+ * The feed-forward addition is fused with the XOR: each keystream word is
+ * applied to the data as soon as it is produced, with no intermediate
+ * keystream buffer. The word loop is also simple enough for the compiler to
+ * vectorize.
+ */
+CHACHA_INLINE void chacha_xor_scalar(const uint32_t state[16],
+                                     const uint8_t *data_in, size_t data_length,
+                                     uint8_t *data_out, const int rounds)
+{
+    uint32_t st[16];
+    uint32_t w_state[16];
+
+    memcpy(st, state, 16 * sizeof(uint32_t));
+
+    while (data_length >= 64) {
+        memcpy(w_state, st, 16 * sizeof(uint32_t));
+        chacha_rounds(w_state, rounds);
+
+        for (int i = 0; i < 16; i++) {
+            store32_le(data_out + 4 * i,
+                       load32_le(data_in + 4 * i) ^ (st[i] + w_state[i]));
+        }
+
+        st[12] += 1;
+        data_in += 64;
+        data_out += 64;
+        data_length -= 64;
+    }
+
+    if (data_length) {
+        memcpy(w_state, st, 16 * sizeof(uint32_t));
+        chacha_rounds(w_state, rounds);
+
+        /* Whole words first, then the bytes of the last partial word. */
+        size_t words = data_length / 4;
+        for (size_t i = 0; i < words; i++) {
+            store32_le(data_out + 4 * i,
+                       load32_le(data_in + 4 * i) ^ (st[i] + w_state[i]));
+        }
+
+        if (data_length % 4) {
+            uint32_t ks = st[words] + w_state[words];
+            for (size_t i = words * 4; i < data_length; i++) {
+                data_out[i] = data_in[i] ^ (uint8_t)ks;
+                ks >>= 8;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Instantiates the core for one round count: <name>_block_state and
+ * <name>_xor_scalar.
+ */
+#define CHACHA_DEFINE_CORE(name, rounds)                                      \
+    static void name##_block_state(const uint32_t state[16],                  \
+                                   uint8_t keystream[64])                     \
+    {                                                                         \
+        chacha_block_state(state, keystream, rounds);                         \
+    }                                                                         \
+    static void name##_xor_scalar(const uint32_t state[16],                   \
+                                  const uint8_t *data_in, size_t data_length, \
+                                  uint8_t *data_out)                          \
+    {                                                                         \
+        chacha_xor_scalar(state, data_in, data_length, data_out, rounds);     \
+    }
+
+CHACHA_DEFINE_CORE(chacha20, 20)
+CHACHA_DEFINE_CORE(chacha12, 12)
+CHACHA_DEFINE_CORE(chacha8, 8)
+
+/* Returns whether the running CPU can execute the given backend. */
+static int backend_supported(chacha20_backend_t backend)
+{
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+    unsigned int features = cpu_features();
+#endif
+
+    switch (backend) {
+    case CHACHA20_BACKEND_SCALAR:
+        return 1;
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+    case CHACHA20_BACKEND_SSSE3:
+        return (features & CPU_FEATURE_SSSE3) != 0;
+    case CHACHA20_BACKEND_AVX2:
+        /* The AVX2 kernel hands short tails to the SSSE3 one. */
+        return (features & CPU_FEATURE_AVX2) && (features & CPU_FEATURE_SSSE3);
+    case CHACHA20_BACKEND_AVX512:
+        /* The AVX-512 kernel hands short tails to the AVX2 one. */
+        return (features & CPU_FEATURE_AVX512F) && backend_supported(CHACHA20_BACKEND_AVX2);
+#endif
+    default:
+        return 0;
+    }
+}
+
+static chacha20_xor_fn backend_kernel(chacha20_backend_t backend)
+{
+    switch (backend) {
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+    case CHACHA20_BACKEND_SSSE3:
+        return chacha20_xor_ssse3;
+    case CHACHA20_BACKEND_AVX2:
+        return chacha20_xor_avx2;
+    case CHACHA20_BACKEND_AVX512:
+        return chacha20_xor_avx512;
+#endif
+    default:
+        return chacha20_xor_scalar;
+    }
+}
+
+/* Active backend; AUTO until resolved on first use. */
+static _Atomic chacha20_backend_t active_backend = CHACHA20_BACKEND_AUTO;
+
+/* Resolves AUTO to the widest backend the running CPU supports. */
+static chacha20_backend_t resolve_backend(void)
+{
+    chacha20_backend_t backend = atomic_load_explicit(&active_backend,
+                                                      memory_order_relaxed);
+    if (backend != CHACHA20_BACKEND_AUTO) {
+        return backend;
+    }
+
+    static const chacha20_backend_t preference[] = {
+        CHACHA20_BACKEND_AVX512, CHACHA20_BACKEND_AVX2, CHACHA20_BACKEND_SSSE3
+    };
+
+    backend = CHACHA20_BACKEND_SCALAR;
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        if (backend_supported(preference[i])) {
+            backend = preference[i];
+            break;
+        }
     }
 
+    atomic_store_explicit(&active_backend, backend, memory_order_relaxed);
+
+    return backend;
+}
+
+static chacha20_xor_fn chacha20_kernel(void)
+{
+    return backend_kernel(resolve_backend());
+}
+
+void chacha20_blocks_multi(const uint32_t states[][16], size_t count,
+                           uint8_t *out)
+{
+    /* Widest multi-state kernel of the active backend. */
+    chacha20_blocks_fn kernel = NULL;
+    size_t lanes = 0;
+    /* Row-layout kernel for a few states at once, if the backend has one. */
+    void (*rows)(const uint32_t [][16], size_t, uint8_t *) = NULL;
+
+    switch (resolve_backend()) {
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+    case CHACHA20_BACKEND_AVX512:
+        kernel = chacha20_blocks_avx512; lanes = 16;
+        rows = chacha20_blocks_rows_avx512;
+        break;
+    case CHACHA20_BACKEND_AVX2:
+        kernel = chacha20_blocks_avx2; lanes = 8;
+        rows = chacha20_blocks_rows_avx2;
+        break;
+    case CHACHA20_BACKEND_SSSE3:
+        kernel = chacha20_blocks_ssse3; lanes = 4;
+        break;
+#endif
+    default:
+        break;
+    }
+
+    while (kernel && count >= lanes) {
+        kernel(states, out);
+        states += lanes;
+        out += 64 * lanes;
+        count -= lanes;
+    }
+
+    /*
+     * The row kernels fill a quarter of the widest pass in the time of a
+     * full one; past that, padding the tail into one more pass is cheaper.
+     */
+    if (count && rows && count <= lanes / 4) {
+        rows(states, count, out);
+    } else if (count > 1 && kernel) {
+        uint32_t padded[16][16] = {{0}};
+        uint8_t buf[16 * 64];
+
+        memcpy(padded, states, 64 * count);
+        kernel((const uint32_t (*)[16])padded, buf);
+        memcpy(out, buf, 64 * count);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            chacha20_block_state(states[i], out + 64 * i);
+        }
+    }
+}
+
+int chacha20_set_backend(chacha20_backend_t backend)
+{
+    if (backend != CHACHA20_BACKEND_AUTO && !backend_supported(backend)) {
+        return 1;
+    }
+
+    atomic_store_explicit(&active_backend, backend, memory_order_relaxed);
+
     return 0;
 }
 
-int chacha20_apply(const uint8_t key[32], uint32_t counter,
-                   const uint8_t nonce[12], const uint8_t *data_in,
-                   size_t data_length, uint8_t *data_out)
+chacha20_backend_t chacha20_get_backend(void)
+{
+    return resolve_backend();
+}
+
+void hchacha20(const uint8_t key[32], const uint8_t nonce[16],
+               uint8_t subkey[32])
+{
+    uint32_t state[16];
+
+    /* The first 4 nonce bytes land in the counter word. */
+    init_state(state, key, nonce + 4, load32_le(nonce));
+    chacha_rounds(state, 20);
+
+    for (int i = 0; i < 4; i++) {
+        store32_le(subkey + 4 * i, state[i]);
+        store32_le(subkey + 16 + 4 * i, state[12 + i]);
+    }
+}
+
+void chacha20_ctx_init(chacha20_ctx_t *ctx, const uint8_t key[32],
+                       const uint8_t nonce[12])
+{
+    init_state(ctx->state, key, nonce, 0);
+    ctx->leftover = 0;
+}
+
+void chacha20_ctx_set_counter(chacha20_ctx_t *ctx, uint32_t counter)
+{
+    ctx->state[12] = counter;
+    ctx->leftover = 0;
+}
+
+void chacha20_ctx_set_nonce(chacha20_ctx_t *ctx, const uint8_t nonce[12])
+{
+    ctx->state[13] = load32_le(nonce);
+    ctx->state[14] = load32_le(nonce + 4);
+    ctx->state[15] = load32_le(nonce + 8);
+    ctx->leftover = 0;
+}
+
+void chacha20_ctx_block(chacha20_ctx_t *ctx, uint8_t keystream[64])
+{
+    chacha20_block_state(ctx->state, keystream);
+    ctx->state[12] += 1;
+    ctx->leftover = 0;
+}
+
+int chacha20_ctx_xor(chacha20_ctx_t *ctx, const uint8_t *data_in,
+                     size_t data_length, uint8_t *data_out)
 {
     /* 2^32 blocks * 64 bytes/block = 274877906944 bytes */
     if (data_length > 274877906944ull) {
-        return 1; 
+        return 1;
     }
 
-    uint8_t keystream[64];
-    size_t full_blocks_no = data_length / 64;
-    size_t remaining = data_length % 64;
+    chacha20_kernel()(ctx->state, data_in, data_length, data_out);
+    ctx->state[12] += (uint32_t)((data_length + 63) / 64);
+    ctx->leftover = 0;
+
+    return 0;
+}
+
+int chacha20_stream_update(chacha20_ctx_t *ctx, const uint8_t *data_in,
+                           size_t data_length, uint8_t *data_out)
+{
+    if (data_length > 274877906944ull) {
+        return 1;
+    }
 
-    for (size_t i = 0; i < full_blocks_no; i++) {
-        chacha20_block(key, counter, nonce, keystream);
-        for (size_t j = 0; j < 64; j++) {
-            data_out[i * 64 + j] = data_in[i * 64 + j] ^ keystream[j];
+    /* 1. Finish the block started by the previous call. */
+    if (ctx->leftover) {
+        size_t n = data_length < ctx->leftover ? data_length : ctx->leftover;
+        const uint8_t *ks = ctx->keystream + 64 - ctx->leftover;
+
+        for (size_t i = 0; i < n; i++) {
+            data_out[i] = data_in[i] ^ ks[i];
         }
-        counter += 1;
+
+        ctx->leftover -= n;
+        data_in += n;
+        data_out += n;
+        data_length -= n;
     }
 
-    if (remaining) {
-        chacha20_block(key, counter, nonce, keystream);
-        for (size_t i = 0; i < remaining; i++) {
-            data_out[full_blocks_no * 64 + i] = data_in[full_blocks_no * 64 + i] ^ keystream[i];
+    /* 2. Whole blocks go straight through the keystream kernel. */
+    size_t bulk = data_length & ~(size_t)63;
+    if (bulk) {
+        chacha20_kernel()(ctx->state, data_in, bulk, data_out);
+        ctx->state[12] += (uint32_t)(bulk / 64);
+        data_in += bulk;
+        data_out += bulk;
+        data_length -= bulk;
+    }
+
+    /* 3. Start a new block for the tail and keep what it does not use. */
+    if (data_length) {
+        chacha20_block_state(ctx->state, ctx->keystream);
+        ctx->state[12] += 1;
+
+        for (size_t i = 0; i < data_length; i++) {
+            data_out[i] = data_in[i] ^ ctx->keystream[i];
         }
+
+        ctx->leftover = 64 - data_length;
+    }
+
+    return 0;
+}
+
+/* Returns whether blocks [base, base + blocks) all fit below 2^32. */
+static int counter_range_ok(uint32_t base, uint64_t blocks)
+{
+    return blocks <= (1ull << 32) - base;
+}
+
+int chacha20_ctx_seek(chacha20_ctx_t *ctx, uint32_t base_counter,
+                      uint64_t byte_offset)
+{
+    uint64_t block = byte_offset / 64;
+    size_t skip = (size_t)(byte_offset % 64);
+
+    if (!counter_range_ok(base_counter, block + (skip ? 1 : 0))) {
+        return 1;
+    }
+
+    chacha20_ctx_set_counter(ctx, base_counter + (uint32_t)block);
+
+    /* Mid-block: generate that block now and skip its first bytes. */
+    if (skip) {
+        chacha20_block_state(ctx->state, ctx->keystream);
+        ctx->state[12] += 1;
+        ctx->leftover = 64 - skip;
+    }
+
+    return 0;
+}
+
+int chacha20_apply_at(const uint8_t key[32], const uint8_t nonce[12],
+                      uint32_t base_counter, uint64_t byte_offset,
+                      const uint8_t *data_in, size_t data_length,
+                      uint8_t *data_out)
+{
+    if (data_length == 0) {
+        return 0;
+    }
+
+    /* No counter range covers more than 2^32 blocks, so longer data never fits. */
+    if ((uint64_t)data_length > (1ull << 32) * 64) {
+        return 1;
+    }
+
+    /*
+     * Blocks up to and including the one holding the last byte, counted
+     * without forming byte_offset + data_length, which may wrap.
+     */
+    const uint64_t blocks = byte_offset / 64 +
+                            (byte_offset % 64 + (uint64_t)data_length + 63) / 64;
+    if (!counter_range_ok(base_counter, blocks)) {
+        return 1;
+    }
+
+    chacha20_ctx_t ctx;
+    chacha20_ctx_init(&ctx, key, nonce);
+    if (chacha20_ctx_seek(&ctx, base_counter, byte_offset) != 0) {
+        return 1;
     }
 
+    return chacha20_stream_update(&ctx, data_in, data_length, data_out);
+}
+
+int chacha20_block(const uint8_t key[32], uint32_t counter,
+                   const uint8_t nonce[12], uint8_t keystream[64])
+{
+    chacha20_ctx_t ctx;
+
+    chacha20_ctx_init(&ctx, key, nonce);
+    chacha20_ctx_set_counter(&ctx, counter);
+    chacha20_ctx_block(&ctx, keystream);
+
     return 0;
-}
\ No newline at end of file
+}
+
+int chacha20_apply(const uint8_t key[32], uint32_t counter,
+                   const uint8_t nonce[12], const uint8_t *data_in,
+                   size_t data_length, uint8_t *data_out)
+{
+    chacha20_ctx_t ctx;
+
+    chacha20_ctx_init(&ctx, key, nonce);
+    chacha20_ctx_set_counter(&ctx, counter);
+
+    return chacha20_ctx_xor(&ctx, data_in, data_length, data_out);
+}
+
+/**
+ * @brief Instantiates the public block/apply pair of a reduced-round variant.
+ *
+ * These run on the portable core only: the SIMD kernels are 20-round.
+ */
+#define CHACHA_DEFINE_REDUCED_API(name)                                       \
+    int name##_block(const uint8_t key[32], uint32_t counter,                 \
+                     const uint8_t nonce[12], uint8_t keystream[64])          \
+    {                                                                         \
+        uint32_t state[16];                                                   \
+                                                                              \
+        init_state(state, key, nonce, counter);                               \
+        name##_block_state(state, keystream);                                 \
+                                                                              \
+        return 0;                                                             \
+    }                                                                         \
+    int name##_apply(const uint8_t key[32], uint32_t counter,                 \
+                     const uint8_t nonce[12], const uint8_t *data_in,         \
+                     size_t data_length, uint8_t *data_out)                   \
+    {                                                                         \
+        uint32_t state[16];                                                   \
+                                                                              \
+        if (data_length > 274877906944ull) {                                  \
+            return 1;                                                         \
+        }                                                                     \
+                                                                              \
+        init_state(state, key, nonce, counter);                               \
+        name##_xor_scalar(state, data_in, data_length, data_out);             \
+                                                                              \
+        return 0;                                                             \
+    }
+
+CHACHA_DEFINE_REDUCED_API(chacha12)
+CHACHA_DEFINE_REDUCED_API(chacha8)
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "chacha20_simd.h"
+
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+#include <immintrin.h>
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+#define ROTL_SHIFT(x, n) \
+    _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+
+/* 16 and 8 bit rotations are whole-byte moves, done with a single vpshufb. */
+#define QUARTER_ROUND(a, b, c, d)                                     \
+    do {                                                              \
+        a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a);       \
+        d = _mm256_shuffle_epi8(d, rot16);                            \
+        c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c);       \
+        b = ROTL_SHIFT(b, 12);                                        \
+        a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a);       \
+        d = _mm256_shuffle_epi8(d, rot8);                             \
+        c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c);       \
+        b = ROTL_SHIFT(b, 7);                                         \
+    } while (0)
+
+/* out[j] = lane j of in[0..7]: an 8x8 transpose of 32-bit words. */
+AVX2_TARGET
+static inline void transpose8x8(const __m256i in[8], __m256i out[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(in[0], in[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(in[0], in[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(in[2], in[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(in[2], in[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(in[4], in[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(in[4], in[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(in[6], in[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(in[6], in[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/**
+ * @brief Computes 8 keystream blocks from per-lane input words.
+ *
+ * Register s[i] holds word i of the eight input states; the blocks may
+ * belong to unrelated keys, nonces and counters. After the rounds each 8x8
+ * group of words is transposed back, so ks[2 * b + h] holds bytes
+ * 32h..32h+31 of block b.
+ */
+AVX2_TARGET
+static inline void keystream8_lanes(const __m256i s[16], __m256i ks[16])
+{
+    const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10,
+                                          5, 4, 7, 6, 1, 0, 3, 2,
+                                          13, 12, 15, 14, 9, 8, 11, 10,
+                                          5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11,
+                                         6, 5, 4, 7, 2, 1, 0, 3,
+                                         14, 13, 12, 15, 10, 9, 8, 11,
+                                         6, 5, 4, 7, 2, 1, 0, 3);
+    __m256i x[16];
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = s[i];
+    }
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm256_add_epi32(x[i], s[i]);
+    }
+
+    /* Words 0..7 form the first half of each block, words 8..15 the second. */
+    for (int h = 0; h < 2; h++) {
+        __m256i t[8];
+
+        transpose8x8(&x[8 * h], t);
+        for (int b = 0; b < 8; b++) {
+            ks[2 * b + h] = t[b];
+        }
+    }
+}
+
+/* Computes 8 consecutive keystream blocks of one state. */
+AVX2_TARGET
+static inline void keystream8(const uint32_t state[16], __m256i ks[16])
+{
+    __m256i s[16];
+
+    for (int i = 0; i < 16; i++) {
+        s[i] = _mm256_set1_epi32((int)state[i]);
+    }
+    s[12] = _mm256_add_epi32(s[12], _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+    keystream8_lanes(s, ks);
+}
+
+AVX2_TARGET
+void chacha20_xor_avx2(const uint32_t state[16], const uint8_t *data_in,
+                       size_t data_length, uint8_t *data_out)
+{
+    uint32_t st[16];
+    __m256i ks[16];
+
+    for (int i = 0; i < 16; i++) {
+        st[i] = state[i];
+    }
+
+    while (data_length >= 512) {
+        keystream8(st, ks);
+        for (int k = 0; k < 16; k++) {
+            __m256i d = _mm256_loadu_si256((const __m256i *)(data_in + 32 * k));
+            _mm256_storeu_si256((__m256i *)(data_out + 32 * k),
+                                _mm256_xor_si256(d, ks[k]));
+        }
+        st[12] += 8;
+        data_in += 512;
+        data_out += 512;
+        data_length -= 512;
+    }
+
+    /* Short tails are cheaper on the 4-way kernel than on a full 8-way pass. */
+    if (data_length > 256) {
+        uint8_t buf[512];
+
+        keystream8(st, ks);
+        for (int k = 0; k < 16; k++) {
+            _mm256_storeu_si256((__m256i *)(buf + 32 * k), ks[k]);
+        }
+        for (size_t i = 0; i < data_length; i++) {
+            data_out[i] = data_in[i] ^ buf[i];
+        }
+    } else if (data_length) {
+        chacha20_xor_ssse3(st, data_in, data_length, data_out);
+    }
+}
+
+AVX2_TARGET
+void chacha20_blocks_avx2(const uint32_t states[8][16], uint8_t out[8 * 64])
+{
+    __m256i s[16];
+    __m256i ks[16];
+
+    /* Transposing each 8x8 word group of the states gives word-major lanes. */
+    for (int h = 0; h < 2; h++) {
+        __m256i rows[8];
+
+        for (int b = 0; b < 8; b++) {
+            rows[b] = _mm256_loadu_si256((const __m256i *)&states[b][8 * h]);
+        }
+        transpose8x8(rows, &s[8 * h]);
+    }
+
+    keystream8_lanes(s, ks);
+
+    /* The transpose leaves the blocks in order, so out is ks stored as is. */
+    for (int k = 0; k < 16; k++) {
+        _mm256_storeu_si256((__m256i *)(out + 32 * k), ks[k]);
+    }
+}
+
+/*
+ * Row layout for one or two blocks: ymm a, b, c, d hold rows 0..3 with one
+ * block per 128-bit lane; diagonal rounds rotate rows b, c and d in-lane.
+ */
+AVX2_TARGET
+void chacha20_blocks_rows_avx2(const uint32_t states[][16], size_t count,
+                               uint8_t *out)
+{
+    const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10,
+                                          5, 4, 7, 6, 1, 0, 3, 2,
+                                          13, 12, 15, 14, 9, 8, 11, 10,
+                                          5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11,
+                                         6, 5, 4, 7, 2, 1, 0, 3,
+                                         14, 13, 12, 15, 10, 9, 8, 11,
+                                         6, 5, 4, 7, 2, 1, 0, 3);
+    const uint32_t *hi = states[count > 1 ? 1 : 0];
+    __m256i row[4];
+
+    for (int r = 0; r < 4; r++) {
+        row[r] = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&states[0][4 * r])),
+            _mm_loadu_si128((const __m128i *)&hi[4 * r]), 1);
+    }
+
+    __m256i a = row[0], b = row[1], c = row[2], d = row[3];
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER_ROUND(a, b, c, d);
+        b = _mm256_shuffle_epi32(b, 0x39);
+        c = _mm256_shuffle_epi32(c, 0x4e);
+        d = _mm256_shuffle_epi32(d, 0x93);
+        QUARTER_ROUND(a, b, c, d);
+        b = _mm256_shuffle_epi32(b, 0x93);
+        c = _mm256_shuffle_epi32(c, 0x4e);
+        d = _mm256_shuffle_epi32(d, 0x39);
+    }
+
+    a = _mm256_add_epi32(a, row[0]);
+    b = _mm256_add_epi32(b, row[1]);
+    c = _mm256_add_epi32(c, row[2]);
+    d = _mm256_add_epi32(d, row[3]);
+
+    /* Low lanes form block 0, high lanes block 1. */
+    _mm256_storeu_si256((__m256i *)out, _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i *)(out + 32), _mm256_permute2x128_si256(c, d, 0x20));
+    if (count > 1) {
+        _mm256_storeu_si256((__m256i *)(out + 64), _mm256_permute2x128_si256(a, b, 0x31));
+        _mm256_storeu_si256((__m256i *)(out + 96), _mm256_permute2x128_si256(c, d, 0x31));
+    }
+}
+#endif /* CHACHA20_HAVE_X86_KERNELS */
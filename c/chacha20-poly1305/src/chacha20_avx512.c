@@ -0,0 +1,213 @@
+#include "chacha20_simd.h"
+
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+#include <immintrin.h>
+#include <string.h>
+
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+/* AVX-512F has native 32-bit rotates, so no shift/or or byte shuffles. */
+#define QUARTER_ROUND(a, b, c, d)                                     \
+    do {                                                              \
+        a = _mm512_add_epi32(a, b); d = _mm512_xor_si512(d, a);       \
+        d = _mm512_rol_epi32(d, 16);                                  \
+        c = _mm512_add_epi32(c, d); b = _mm512_xor_si512(b, c);       \
+        b = _mm512_rol_epi32(b, 12);                                  \
+        a = _mm512_add_epi32(a, b); d = _mm512_xor_si512(d, a);       \
+        d = _mm512_rol_epi32(d, 8);                                   \
+        c = _mm512_add_epi32(c, d); b = _mm512_xor_si512(b, c);       \
+        b = _mm512_rol_epi32(b, 7);                                   \
+    } while (0)
+
+/*
+ * out[j] = lane j of in[0..15]: a 16x16 transpose of 32-bit words. The
+ * first step builds 4x4 word blocks inside each 128-bit lane, the second
+ * moves the lanes across registers.
+ */
+AVX512_TARGET
+static inline void transpose16x16(const __m512i in[16], __m512i out[16])
+{
+    __m512i v[16];
+
+    /* v[4 * g + j], lane L: words 4g..4g+3 of block 4L + j. */
+    for (int g = 0; g < 4; g++) {
+        __m512i t0 = _mm512_unpacklo_epi32(in[4 * g + 0], in[4 * g + 1]);
+        __m512i t1 = _mm512_unpacklo_epi32(in[4 * g + 2], in[4 * g + 3]);
+        __m512i t2 = _mm512_unpackhi_epi32(in[4 * g + 0], in[4 * g + 1]);
+        __m512i t3 = _mm512_unpackhi_epi32(in[4 * g + 2], in[4 * g + 3]);
+
+        v[4 * g + 0] = _mm512_unpacklo_epi64(t0, t1);
+        v[4 * g + 1] = _mm512_unpackhi_epi64(t0, t1);
+        v[4 * g + 2] = _mm512_unpacklo_epi64(t2, t3);
+        v[4 * g + 3] = _mm512_unpackhi_epi64(t2, t3);
+    }
+
+    for (int j = 0; j < 4; j++) {
+        __m512i p0 = _mm512_shuffle_i32x4(v[0 + j], v[4 + j], 0x44);
+        __m512i p1 = _mm512_shuffle_i32x4(v[0 + j], v[4 + j], 0xee);
+        __m512i p2 = _mm512_shuffle_i32x4(v[8 + j], v[12 + j], 0x44);
+        __m512i p3 = _mm512_shuffle_i32x4(v[8 + j], v[12 + j], 0xee);
+
+        out[0 + j] = _mm512_shuffle_i32x4(p0, p2, 0x88);
+        out[4 + j] = _mm512_shuffle_i32x4(p0, p2, 0xdd);
+        out[8 + j] = _mm512_shuffle_i32x4(p1, p3, 0x88);
+        out[12 + j] = _mm512_shuffle_i32x4(p1, p3, 0xdd);
+    }
+}
+
+/**
+ * @brief Computes 16 keystream blocks from per-lane input words.
+ *
+ * Register s[i] holds word i of the sixteen input states; the blocks may
+ * belong to unrelated keys, nonces and counters. The transpose first
+ * builds 4x4 word blocks inside each 128-bit lane, then moves the lanes
+ * across registers, so ks[b] holds the whole 64 bytes of block b.
+ */
+AVX512_TARGET
+static inline void keystream16_lanes(const __m512i s[16], __m512i ks[16])
+{
+    __m512i x[16];
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = s[i];
+    }
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm512_add_epi32(x[i], s[i]);
+    }
+
+    transpose16x16(x, ks);
+}
+
+/* Computes 16 consecutive keystream blocks of one state. */
+AVX512_TARGET
+static inline void keystream16(const uint32_t state[16], __m512i ks[16])
+{
+    __m512i s[16];
+
+    for (int i = 0; i < 16; i++) {
+        s[i] = _mm512_set1_epi32((int)state[i]);
+    }
+    s[12] = _mm512_add_epi32(s[12], _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8,
+                                                     7, 6, 5, 4, 3, 2, 1, 0));
+
+    keystream16_lanes(s, ks);
+}
+
+AVX512_TARGET
+void chacha20_xor_avx512(const uint32_t state[16], const uint8_t *data_in,
+                         size_t data_length, uint8_t *data_out)
+{
+    uint32_t st[16];
+    __m512i ks[16];
+
+    for (int i = 0; i < 16; i++) {
+        st[i] = state[i];
+    }
+
+    while (data_length >= 1024) {
+        keystream16(st, ks);
+        for (int k = 0; k < 16; k++) {
+            __m512i d = _mm512_loadu_si512((const void *)(data_in + 64 * k));
+            _mm512_storeu_si512((void *)(data_out + 64 * k),
+                                _mm512_xor_si512(d, ks[k]));
+        }
+        st[12] += 16;
+        data_in += 1024;
+        data_out += 1024;
+        data_length -= 1024;
+    }
+
+    /* Short tails are cheaper on the narrower kernels. */
+    if (data_length > 512) {
+        uint8_t buf[1024];
+
+        keystream16(st, ks);
+        for (int k = 0; k < 16; k++) {
+            _mm512_storeu_si512((void *)(buf + 64 * k), ks[k]);
+        }
+        for (size_t i = 0; i < data_length; i++) {
+            data_out[i] = data_in[i] ^ buf[i];
+        }
+    } else if (data_length) {
+        chacha20_xor_avx2(st, data_in, data_length, data_out);
+    }
+}
+
+AVX512_TARGET
+void chacha20_blocks_avx512(const uint32_t states[16][16], uint8_t out[16 * 64])
+{
+    __m512i s[16];
+    __m512i ks[16];
+
+    /* The states are the rows of a 16x16 word matrix; its transpose is s. */
+    for (int b = 0; b < 16; b++) {
+        s[b] = _mm512_loadu_si512((const void *)states[b]);
+    }
+    transpose16x16(s, s);
+
+    keystream16_lanes(s, ks);
+
+    /* The transpose leaves the blocks in order, so out is ks stored as is. */
+    for (int k = 0; k < 16; k++) {
+        _mm512_storeu_si512((void *)(out + 64 * k), ks[k]);
+    }
+}
+
+/*
+ * Row layout for a handful of blocks: zmm a, b, c, d hold rows 0..3 of up to
+ * four blocks, one block per 128-bit lane. Diagonal rounds rotate rows b, c
+ * and d within each lane, so a pass costs about one block's latency.
+ */
+AVX512_TARGET
+void chacha20_blocks_rows_avx512(const uint32_t states[][16], size_t count,
+                                 uint8_t *out)
+{
+    __m512i row[4];
+    uint32_t tmp[4][16];
+
+    /* Unused lanes repeat block 0; their output is dropped. */
+    for (int r = 0; r < 4; r++) {
+        for (size_t j = 0; j < 4; j++) {
+            memcpy(&tmp[r][4 * j], &states[j < count ? j : 0][4 * r], 16);
+        }
+        row[r] = _mm512_loadu_si512((const void *)tmp[r]);
+    }
+
+    __m512i a = row[0], b = row[1], c = row[2], d = row[3];
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER_ROUND(a, b, c, d);
+        b = _mm512_shuffle_epi32(b, _MM_PERM_ADCB);
+        c = _mm512_shuffle_epi32(c, _MM_PERM_BADC);
+        d = _mm512_shuffle_epi32(d, _MM_PERM_CBAD);
+        QUARTER_ROUND(a, b, c, d);
+        b = _mm512_shuffle_epi32(b, _MM_PERM_CBAD);
+        c = _mm512_shuffle_epi32(c, _MM_PERM_BADC);
+        d = _mm512_shuffle_epi32(d, _MM_PERM_ADCB);
+    }
+
+    _mm512_storeu_si512((void *)tmp[0], _mm512_add_epi32(a, row[0]));
+    _mm512_storeu_si512((void *)tmp[1], _mm512_add_epi32(b, row[1]));
+    _mm512_storeu_si512((void *)tmp[2], _mm512_add_epi32(c, row[2]));
+    _mm512_storeu_si512((void *)tmp[3], _mm512_add_epi32(d, row[3]));
+
+    for (size_t j = 0; j < count; j++) {
+        for (int r = 0; r < 4; r++) {
+            memcpy(out + 64 * j + 16 * r, &tmp[r][4 * j], 16);
+        }
+    }
+}
+#endif /* CHACHA20_HAVE_X86_KERNELS */
@@ -0,0 +1,558 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "chacha20_poly1305_stream.h"
+#include "chacha20_rng.h"
+#include "thread_pool.h"
+
+/*
+ * File layout: 8-byte magic, then exactly what the streaming AEAD produces
+ * (16-byte header, 64 KiB segments each followed by its tag, a shorter
+ * final segment). Segment i is sealed under IV i on its own, so any number
+ * of segments can be processed at once.
+ */
+static const uint8_t file_magic[8] = { 'C', 'H', 'A', 'P', 'O', 'L', 'Y', '1' };
+
+#define FILE_HEADER_BYTES (sizeof(file_magic) + CHACHA20_STREAM_HEADER_BYTES)
+#define SEGMENT_BYTES CHACHA20_STREAM_SEGMENT_BYTES
+#define SEALED_BYTES (CHACHA20_STREAM_SEGMENT_BYTES + CHACHA20_STREAM_TAG_BYTES)
+/* Segments per read when streaming: 4 MiB of plaintext. */
+#define STREAM_BATCH_SEGMENTS 64
+/* Alignment of the streaming buffers (one page). */
+#define BUFFER_ALIGN 4096
+
+/* A run of consecutive segments, one thread pool task per segment. */
+struct batch {
+    const chacha20_stream_state_t *base;    /* Stream state at segment 0 */
+    int decrypt;
+    const uint8_t *in;
+    uint8_t *out;
+    uint64_t first;         /* Stream index of the batch's first segment */
+    size_t count;           /* Segments in the batch */
+    size_t last_len;        /* Plaintext bytes of the batch's last segment */
+    atomic_int failed;
+};
+
+/* Writes zeros the compiler cannot drop as dead stores. */
+static void wipe(void *p, size_t len)
+{
+    volatile uint8_t *v = p;
+
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+static void batch_task(void *arg, size_t index)
+{
+    struct batch *b = arg;
+    chacha20_stream_state_t st = *b->base;
+    const size_t pt_len = index + 1 == b->count ? b->last_len : SEGMENT_BYTES;
+    int final;
+    int ret;
+
+    st.counter = b->first + index;
+
+    if (b->decrypt) {
+        ret = chacha20_stream_pull(&st, b->in + index * SEALED_BYTES,
+                                   pt_len + CHACHA20_STREAM_TAG_BYTES,
+                                   b->out + index * SEGMENT_BYTES, &final);
+    } else {
+        ret = chacha20_stream_push(&st, b->in + index * SEGMENT_BYTES, pt_len,
+                                   b->out + index * SEALED_BYTES);
+    }
+
+    if (ret != 0) {
+        atomic_store(&b->failed, 1);
+    }
+
+    wipe(&st, sizeof(st));
+}
+
+/* Seals or opens `count` segments in parallel; returns non-zero on failure. */
+static int run_batch(const chacha20_stream_state_t *base, int decrypt,
+                     const uint8_t *in, uint8_t *out, uint64_t first,
+                     size_t count, size_t last_len, unsigned int threads)
+{
+    struct batch b = { base, decrypt, in, out, first, count, last_len, 0 };
+
+    thread_pool_run(count, batch_task, &b, threads);
+
+    return atomic_load(&b.failed);
+}
+
+/* Reads until `len` bytes or end of input; returns the count or -1. */
+static ssize_t read_full(int fd, uint8_t *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t n = read(fd, buf + done, len - done);
+
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+
+    return (ssize_t)done;
+}
+
+static int write_full(int fd, const uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+
+        if (n <= 0) {
+            return 1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/* Starts the stream: a fresh header when encrypting, the input's when decrypting. */
+static int stream_begin(chacha20_stream_state_t *st, int decrypt,
+                        const uint8_t key[32], uint8_t header[FILE_HEADER_BYTES])
+{
+    if (decrypt) {
+        if (memcmp(header, file_magic, sizeof(file_magic)) != 0) {
+            fprintf(stderr, "chacha20-file: input is not an encrypted file\n");
+            return 1;
+        }
+        chacha20_stream_init_pull(st, key, header + sizeof(file_magic));
+        return 0;
+    }
+
+    memcpy(header, file_magic, sizeof(file_magic));
+    if (chacha20_stream_init_push(st, key, header + sizeof(file_magic)) != 0) {
+        fprintf(stderr, "chacha20-file: no entropy for the stream header\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Regular input and output files: map both and process every segment at once. */
+static int run_mapped(int decrypt, int in_fd, int out_fd, size_t in_size,
+                      const uint8_t key[32], unsigned int threads, uint64_t *bytes)
+{
+    chacha20_stream_state_t st;
+    uint8_t *in_map = NULL;
+    uint8_t *out_map = NULL;
+    size_t segments, last_len, out_size;
+    int ret = 1;
+
+    if (decrypt && in_size < FILE_HEADER_BYTES + CHACHA20_STREAM_TAG_BYTES) {
+        fprintf(stderr, "chacha20-file: input is truncated\n");
+        return 1;
+    }
+
+    if (in_size > 0) {
+        in_map = mmap(NULL, in_size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+        if (in_map == MAP_FAILED) {
+            perror("chacha20-file: mmap input");
+            return 1;
+        }
+        madvise(in_map, in_size, MADV_SEQUENTIAL);
+    }
+
+    if (decrypt) {
+        const size_t body = in_size - FILE_HEADER_BYTES;
+        const size_t rem = body % SEALED_BYTES;
+
+        if (rem < CHACHA20_STREAM_TAG_BYTES) {
+            fprintf(stderr, "chacha20-file: input is truncated\n");
+            goto out;
+        }
+        segments = body / SEALED_BYTES + 1;
+        last_len = rem - CHACHA20_STREAM_TAG_BYTES;
+        out_size = (segments - 1) * SEGMENT_BYTES + last_len;
+    } else {
+        segments = in_size / SEGMENT_BYTES + 1;
+        last_len = in_size % SEGMENT_BYTES;
+        out_size = FILE_HEADER_BYTES + (segments - 1) * SEALED_BYTES + last_len +
+                   CHACHA20_STREAM_TAG_BYTES;
+    }
+
+    if (ftruncate(out_fd, (off_t)out_size) != 0) {
+        perror("chacha20-file: resize output");
+        goto out;
+    }
+    if (out_size > 0) {
+        out_map = mmap(NULL, out_size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+        if (out_map == MAP_FAILED) {
+            out_map = NULL;
+            perror("chacha20-file: mmap output");
+            goto out;
+        }
+    }
+
+    if (decrypt) {
+        uint8_t header[FILE_HEADER_BYTES];
+
+        memcpy(header, in_map, FILE_HEADER_BYTES);
+        if (stream_begin(&st, 1, key, header) != 0) {
+            goto out;
+        }
+        if (run_batch(&st, 1, in_map + FILE_HEADER_BYTES, out_map, 0, segments,
+                      last_len, threads) != 0) {
+            fprintf(stderr, "chacha20-file: authentication failed\n");
+            goto out;
+        }
+        *bytes = out_size;
+    } else {
+        if (stream_begin(&st, 0, key, out_map) != 0) {
+            goto out;
+        }
+        if (run_batch(&st, 0, in_map, out_map + FILE_HEADER_BYTES, 0, segments,
+                      last_len, threads) != 0) {
+            goto out;
+        }
+        *bytes = in_size;
+    }
+
+    ret = 0;
+
+out:
+    wipe(&st, sizeof(st));
+    if (out_map != NULL) {
+        munmap(out_map, out_size);
+    }
+    if (in_map != NULL) {
+        munmap(in_map, in_size);
+    }
+
+    return ret;
+}
+
+/*
+ * Pipes and terminals: read large batches and process each in parallel.
+ * When decrypting, a batch is only written once all of its segments have
+ * authenticated.
+ */
+static int run_streamed(int decrypt, int in_fd, int out_fd, const uint8_t key[32],
+                        unsigned int threads, uint64_t *bytes)
+{
+    const size_t in_batch = STREAM_BATCH_SEGMENTS * (decrypt ? SEALED_BYTES : SEGMENT_BYTES);
+    const size_t out_batch = STREAM_BATCH_SEGMENTS * (decrypt ? SEGMENT_BYTES : SEALED_BYTES);
+    const size_t in_unit = decrypt ? SEALED_BYTES : SEGMENT_BYTES;
+    const size_t overhead = decrypt ? CHACHA20_STREAM_TAG_BYTES : 0;
+    uint8_t header[FILE_HEADER_BYTES];
+    chacha20_stream_state_t st;
+    uint8_t *in_buf = aligned_alloc(BUFFER_ALIGN, in_batch);
+    uint8_t *out_buf = aligned_alloc(BUFFER_ALIGN, out_batch);
+    uint64_t first = 0;
+    int ret = 1;
+
+    memset(&st, 0, sizeof(st));
+    *bytes = 0;
+
+    if (in_buf == NULL || out_buf == NULL) {
+        fprintf(stderr, "chacha20-file: out of memory\n");
+        goto out;
+    }
+
+    if (decrypt) {
+        if (read_full(in_fd, header, FILE_HEADER_BYTES) != (ssize_t)FILE_HEADER_BYTES) {
+            fprintf(stderr, "chacha20-file: input is truncated\n");
+            goto out;
+        }
+        if (stream_begin(&st, 1, key, header) != 0) {
+            goto out;
+        }
+    } else {
+        if (stream_begin(&st, 0, key, header) != 0 ||
+            write_full(out_fd, header, FILE_HEADER_BYTES) != 0) {
+            goto out;
+        }
+    }
+
+    for (;;) {
+        ssize_t got = read_full(in_fd, in_buf, in_batch);
+
+        if (got < 0) {
+            perror("chacha20-file: read");
+            goto out;
+        }
+
+        /* A short read means end of input: its last segment is the final one. */
+        const int final = (size_t)got < in_batch;
+        size_t count = (size_t)got / in_unit;
+        size_t last_len = SEGMENT_BYTES;
+
+        if (final) {
+            const size_t rem = (size_t)got % in_unit;
+
+            if (rem < overhead) {
+                fprintf(stderr, "chacha20-file: input is truncated\n");
+                goto out;
+            }
+            count++;
+            last_len = rem - overhead;
+        }
+
+        if (run_batch(&st, decrypt, in_buf, out_buf, first, count, last_len,
+                      threads) != 0) {
+            if (decrypt) {
+                fprintf(stderr, "chacha20-file: authentication failed\n");
+            }
+            goto out;
+        }
+
+        const size_t pt_bytes = (count - 1) * SEGMENT_BYTES + last_len;
+        const size_t out_bytes = decrypt
+            ? pt_bytes : pt_bytes + count * CHACHA20_STREAM_TAG_BYTES;
+
+        if (write_full(out_fd, out_buf, out_bytes) != 0) {
+            perror("chacha20-file: write");
+            goto out;
+        }
+
+        *bytes += pt_bytes;
+        first += count;
+        if (final) {
+            break;
+        }
+    }
+
+    ret = 0;
+
+out:
+    wipe(&st, sizeof(st));
+    if (out_buf != NULL) {
+        wipe(out_buf, out_batch);
+    }
+    free(in_buf);
+    free(out_buf);
+
+    return ret;
+}
+
+static int load_key(const char *path, uint8_t key[32])
+{
+    int fd = open(path, O_RDONLY);
+    uint8_t extra;
+
+    if (fd < 0) {
+        perror("chacha20-file: key file");
+        return 1;
+    }
+
+    const int ok = read_full(fd, key, 32) == 32 && read_full(fd, &extra, 1) == 0;
+    close(fd);
+
+    if (!ok) {
+        fprintf(stderr, "chacha20-file: key file must hold exactly 32 bytes\n");
+        wipe(key, 32);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int keygen(const char *path)
+{
+    uint8_t key[32];
+    int ret = 1;
+
+    if (chacha20_rng_bytes(key, sizeof(key)) != 0) {
+        fprintf(stderr, "chacha20-file: no entropy for the key\n");
+        return 1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        perror("chacha20-file: key file");
+    } else {
+        ret = write_full(fd, key, sizeof(key));
+        if (close(fd) != 0) {
+            ret = 1;
+        }
+    }
+
+    wipe(key, sizeof(key));
+
+    return ret;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: chacha20-file encrypt|decrypt -k KEYFILE [-t THREADS] [-q] [INPUT [OUTPUT]]\n"
+            "       chacha20-file keygen KEYFILE\n"
+            "INPUT and OUTPUT default to stdin and stdout; '-' selects them explicitly.\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *key_path = NULL;
+    const char *in_path = NULL;
+    const char *out_path = NULL;
+    unsigned int threads = thread_pool_cpu_count();
+    int quiet = 0;
+    int decrypt;
+    int opt;
+
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    if (strcmp(argv[1], "keygen") == 0) {
+        if (argc != 3) {
+            usage();
+            return 2;
+        }
+        return keygen(argv[2]);
+    } else if (strcmp(argv[1], "encrypt") == 0) {
+        decrypt = 0;
+    } else if (strcmp(argv[1], "decrypt") == 0) {
+        decrypt = 1;
+    } else {
+        usage();
+        return 2;
+    }
+
+    while ((opt = getopt(argc - 1, argv + 1, "k:t:q")) != -1) {
+        switch (opt) {
+        case 'k':
+            key_path = optarg;
+            break;
+        case 't':
+            threads = (unsigned int)strtoul(optarg, NULL, 10);
+            if (threads == 0) {
+                threads = 1;
+            }
+            break;
+        case 'q':
+            quiet = 1;
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+
+    const int rest = argc - 1 - optind;
+    if (key_path == NULL || rest > 2) {
+        usage();
+        return 2;
+    }
+    if (rest >= 1 && strcmp(argv[1 + optind], "-") != 0) {
+        in_path = argv[1 + optind];
+    }
+    if (rest == 2 && strcmp(argv[2 + optind], "-") != 0) {
+        out_path = argv[2 + optind];
+    }
+
+    uint8_t key[32];
+    if (load_key(key_path, key) != 0) {
+        return 1;
+    }
+
+    int in_fd = in_path ? open(in_path, O_RDONLY) : STDIN_FILENO;
+    if (in_fd < 0) {
+        perror("chacha20-file: input");
+        wipe(key, sizeof(key));
+        return 1;
+    }
+
+    struct stat in_st;
+    struct stat out_st;
+    fstat(in_fd, &in_st);
+
+    /* Replacing the output must not destroy the input. */
+    if (out_path != NULL && stat(out_path, &out_st) == 0 &&
+        out_st.st_dev == in_st.st_dev && out_st.st_ino == in_st.st_ino) {
+        fprintf(stderr, "chacha20-file: input and output are the same file\n");
+        wipe(key, sizeof(key));
+        return 1;
+    }
+
+    /*
+     * A named output is written to a temporary file beside it and only
+     * renamed into place once everything has authenticated, so a failed run
+     * never shows partial or unauthenticated data under that name.
+     */
+    char *tmp_path = NULL;
+    int out_fd = STDOUT_FILENO;
+
+    if (out_path != NULL) {
+        tmp_path = malloc(strlen(out_path) + sizeof(".XXXXXX"));
+        if (tmp_path == NULL) {
+            fprintf(stderr, "chacha20-file: out of memory\n");
+            wipe(key, sizeof(key));
+            return 1;
+        }
+        strcpy(tmp_path, out_path);
+        strcat(tmp_path, ".XXXXXX");
+
+        out_fd = mkstemp(tmp_path);
+        if (out_fd < 0) {
+            perror("chacha20-file: output");
+            free(tmp_path);
+            wipe(key, sizeof(key));
+            return 1;
+        }
+    }
+    fstat(out_fd, &out_st);
+
+    struct timespec t0, t1;
+    uint64_t bytes = 0;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    /* Only an output opened here is known to be readable and safe to resize. */
+    if (S_ISREG(in_st.st_mode) && out_path != NULL && S_ISREG(out_st.st_mode)) {
+        ret = run_mapped(decrypt, in_fd, out_fd, (size_t)in_st.st_size, key,
+                         threads, &bytes);
+    } else {
+        ret = run_streamed(decrypt, in_fd, out_fd, key, threads, &bytes);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    wipe(key, sizeof(key));
+
+    if (out_path != NULL) {
+        if (close(out_fd) != 0) {
+            perror("chacha20-file: output");
+            ret = 1;
+        }
+        if (ret == 0 && rename(tmp_path, out_path) != 0) {
+            perror("chacha20-file: output");
+            ret = 1;
+        }
+        if (ret != 0) {
+            unlink(tmp_path);
+        }
+        free(tmp_path);
+    }
+    if (in_path != NULL) {
+        close(in_fd);
+    }
+
+    if (ret == 0 && !quiet) {
+        const double secs = (double)(t1.tv_sec - t0.tv_sec) +
+                            (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+        fprintf(stderr, "chacha20-file: %s %llu bytes in %.3f s (%.1f MiB/s, %u threads)\n",
+                decrypt ? "decrypted" : "encrypted", (unsigned long long)bytes, secs,
+                secs > 0 ? (double)bytes / secs / (1024.0 * 1024.0) : 0.0, threads);
+    }
+
+    return ret;
+}
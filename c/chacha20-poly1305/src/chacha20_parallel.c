@@ -0,0 +1,62 @@
+#include "chacha20.h"
+#include "thread_pool.h"
+
+/* One contiguous counter range per task. */
+struct apply_job {
+    chacha20_ctx_t ctx;    /* Context positioned at the first block */
+    const uint8_t *data_in;
+    uint8_t *data_out;
+    size_t data_length;
+    size_t chunk;          /* Bytes per task, a multiple of 64 */
+};
+
+static void apply_task(void *arg, size_t index)
+{
+    const struct apply_job *job = arg;
+    size_t offset = index * job->chunk;
+    size_t length = job->data_length - offset;
+    if (length > job->chunk) {
+        length = job->chunk;
+    }
+
+    chacha20_ctx_t ctx = job->ctx;
+    chacha20_ctx_set_counter(&ctx, ctx.state[12] + (uint32_t)(offset / 64));
+    chacha20_ctx_xor(&ctx, job->data_in + offset, length, job->data_out + offset);
+}
+
+int chacha20_apply_parallel(const uint8_t key[32], uint32_t counter,
+                            const uint8_t nonce[12], const uint8_t *data_in,
+                            size_t data_length, uint8_t *data_out,
+                            const chacha20_parallel_opts_t *opts)
+{
+    /* 2^32 blocks * 64 bytes/block = 274877906944 bytes */
+    if (data_length > 274877906944ull) {
+        return 1;
+    }
+
+    unsigned int workers = opts && opts->workers ? opts->workers : thread_pool_cpu_count();
+    size_t min_chunk = opts && opts->min_chunk ? opts->min_chunk
+                                               : CHACHA20_PARALLEL_MIN_CHUNK;
+
+    struct apply_job job;
+    chacha20_ctx_init(&job.ctx, key, nonce);
+    chacha20_ctx_set_counter(&job.ctx, counter);
+
+    size_t tasks = data_length / min_chunk;
+    if (tasks > workers) {
+        tasks = workers;
+    }
+    if (tasks <= 1) {
+        return chacha20_ctx_xor(&job.ctx, data_in, data_length, data_out);
+    }
+
+    /* Split on block boundaries so every task starts on a fresh counter. */
+    job.chunk = ((data_length + tasks - 1) / tasks + 63) & ~(size_t)63;
+    job.data_in = data_in;
+    job.data_out = data_out;
+    job.data_length = data_length;
+
+    thread_pool_run((data_length + job.chunk - 1) / job.chunk, apply_task, &job, workers);
+
+    return 0;
+}
@@ -1,7 +1,11 @@
 #include "chacha20_poly1305.h"
 #include "chacha20.h"
 #include "poly1305.h"
-#include <stdlib.h>
+#include "chacha20_simd.h"
+#include "poly1305_internal.h"
+#include "chacha20_poly1305_internal.h"
+#include "thread_pool.h"
+#include <stdint.h>
 #include <string.h>
 
 /* Converts a 64-bit length into an 8-byte Little-Endian array */
@@ -13,52 +17,97 @@ static void uint64_to_le_bytes(uint8_t out[8], uint64_t val)
     }
 }
 
-/* Helper to assemble the Poly1305 MAC payload:
- * AAD | pad(AAD) | Ciphertext | pad(Ciphertext) | len(AAD) | len(Ciphertext) */
-static int compute_poly1305_tag(const uint8_t poly_key[32], const uint8_t *ct,
-                                size_t ct_len, const uint8_t *aad, size_t aad_len,
-                                uint8_t tag[16])
+/* Derives the one-time Poly1305 key from block 0, leaving the counter at 1. */
+static void aead_poly_key(chacha20_ctx_t *ctx, uint8_t poly_key[32])
 {
-    /* Padding required to align to 16-byte. */
-    size_t aad_pad_len = (16 - (aad_len % 16)) % 16;
-    size_t ct_pad_len  = (16 - (ct_len % 16)) % 16;
+    uint8_t keystream[64];
 
-    size_t mac_data_len = aad_len + aad_pad_len + ct_len + ct_pad_len + 16;
-    uint8_t *mac_data = calloc(1, mac_data_len);
-    if (!mac_data) {
-        return 1;
+    chacha20_ctx_set_counter(ctx, 0);
+    chacha20_ctx_block(ctx, keystream);
+    memcpy(poly_key, keystream, 32);
+}
+
+/*
+ * Stitched mode works through the message in tiles small enough that the
+ * input and output of a tile are still in L1 when Poly1305 reads the
+ * ciphertext, so a large message crosses the memory bus once instead of
+ * twice. A multiple of 64 keeps every tile on a keystream block boundary.
+ */
+#define AEAD_TILE_SIZE 8192
+
+/* Zeroes memory through a volatile pointer so the store is not elided. */
+static void wipe(void *p, size_t len)
+{
+    volatile uint8_t *v = p;
+
+    while (len--) {
+        *v++ = 0;
     }
+}
+
+/* Feeds the zero bytes that pad a field of `len` bytes to a 16-byte boundary. */
+static void aead_mac_pad(poly1305_state_t *st, size_t len)
+{
+    static const uint8_t zeros[16] = {0};
 
-    size_t offset = 0;
+    if (len % 16) {
+        poly1305_update(st, zeros, 16 - (len % 16));
+    }
+}
 
-    /* 1. AAD + padding. */
-    memcpy(mac_data, aad, aad_len);
-    offset += aad_len + aad_pad_len;
+/* Closes the MAC with len(AAD) | len(Ciphertext) and writes the tag. */
+static void aead_mac_final(poly1305_state_t *st, size_t aad_len, size_t ct_len,
+                           uint8_t tag[16])
+{
+    uint8_t lengths[16];
 
-    /* 2. Ciphertext + padding. */
-    memcpy(mac_data + offset, ct, ct_len);
-    offset += ct_len + ct_pad_len;
+    uint64_to_le_bytes(lengths, (uint64_t)aad_len);
+    uint64_to_le_bytes(lengths + 8, (uint64_t)ct_len);
+    poly1305_update(st, lengths, sizeof(lengths));
+    poly1305_final(st, tag);
+}
 
-    /* 3. Original length of AAD and Ciphertext. */
-    uint64_to_le_bytes(mac_data + offset, (uint64_t)aad_len);
-    uint64_to_le_bytes(mac_data + offset + 8, (uint64_t)ct_len);
+/* Starts the MAC with AAD | pad(AAD). */
+static void aead_mac_init(poly1305_state_t *st, const uint8_t poly_key[32],
+                          const uint8_t *aad, size_t aad_len)
+{
+    poly1305_init(st, poly_key);
 
-    /* 4. MAC computation. */
-    poly1305_mac(poly_key, mac_data, mac_data_len, tag);
+    if (aad_len) {
+        poly1305_update(st, aad, aad_len);
+        aead_mac_pad(st, aad_len);
+    }
+}
 
-    free(mac_data);
+/* Encrypts a span tile by tile, MACing each ciphertext tile while it is
+ * still cached. Keystream and MAC state carry over to the next span. */
+static void aead_seal_span(chacha20_ctx_t *ctx, poly1305_state_t *st,
+                           const uint8_t *in, size_t len, uint8_t *out)
+{
+    for (size_t off = 0; off < len; off += AEAD_TILE_SIZE) {
+        size_t n = len - off < AEAD_TILE_SIZE ? len - off : AEAD_TILE_SIZE;
 
-    return 0;
+        chacha20_stream_update(ctx, in + off, n, out + off);
+        poly1305_update(st, out + off, n);
+    }
 }
 
-int chacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t iv[8],
-                              const uint8_t constant[4], const uint8_t *pt,
-                              size_t pt_len, const uint8_t *aad, size_t aad_len,
-                              uint8_t *ct, uint8_t tag[16])
+/* MACs each ciphertext tile before decrypting it, so out may alias in. */
+static void aead_open_span(chacha20_ctx_t *ctx, poly1305_state_t *st,
+                           const uint8_t *in, size_t len, uint8_t *out)
 {
-    uint8_t poly_key[32];
-    uint8_t nonce[12];
+    for (size_t off = 0; off < len; off += AEAD_TILE_SIZE) {
+        size_t n = len - off < AEAD_TILE_SIZE ? len - off : AEAD_TILE_SIZE;
+
+        poly1305_update(st, in + off, n);
+        chacha20_stream_update(ctx, in + off, n, out + off);
+    }
+}
 
+/* Builds the 96-bit nonce: constant | IV. */
+static void aead_nonce(uint8_t nonce[12], const uint8_t iv[8],
+                       const uint8_t constant[4])
+{
     for (int i = 0; i < 4; i++) {
         nonce[i] = constant[i];
     }
@@ -66,14 +115,189 @@ int chacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t iv[8],
     for (int i = 0; i < 8; i++) {
         nonce[4 + i] = iv[i];
     }
+}
 
-    poly1305_key_gen(key, nonce, poly_key);
+/* Expands key and nonce and derives the Poly1305 key, leaving the context
+ * at block 1. */
+static void aead_setup(chacha20_ctx_t *ctx, const uint8_t key[32],
+                       const uint8_t iv[8], const uint8_t constant[4],
+                       uint8_t poly_key[32])
+{
+    uint8_t nonce[12];
 
-    if (pt && pt_len > 0) {
-        chacha20_apply(key, 1, nonce, pt, pt_len, ct);
+    aead_nonce(nonce, iv, constant);
+    chacha20_ctx_init(ctx, key, nonce);
+    aead_poly_key(ctx, poly_key);
+}
+
+/*
+ * Messages this short need at most four blocks including the Poly1305 key
+ * block, so one row-layout pass covers all of them.
+ */
+#define AEAD_SMALL_MAX_LEN 192
+
+/* Computes blocks 0..blocks-1 of the context's nonce in one multi-state pass. */
+static void aead_small_keystream(const chacha20_ctx_t *ctx, size_t blocks,
+                                 uint8_t keystream[4 * 64])
+{
+    uint32_t states[4][16];
+
+    for (size_t i = 0; i < blocks; i++) {
+        memcpy(states[i], ctx->state, sizeof(states[i]));
+        states[i][12] = (uint32_t)i;
+    }
+
+    chacha20_blocks_multi((const uint32_t (*)[16])states, blocks, keystream);
+}
+
+/*
+ * Seals from keystream computed ahead of time: block 0 (the Poly1305 key)
+ * followed by the blocks covering pt_len bytes.
+ */
+static void aead_seal_keystream(const uint8_t *keystream, const uint8_t *pt,
+                                size_t pt_len, const uint8_t *aad, size_t aad_len,
+                                uint8_t *ct, uint8_t tag[16])
+{
+    poly1305_state_t st;
+
+    for (size_t i = 0; i < pt_len; i++) {
+        ct[i] = pt[i] ^ keystream[64 + i];
+    }
+
+    aead_mac_init(&st, keystream, aad, aad_len);
+    if (pt_len) {
+        poly1305_update(&st, ct, pt_len);
+        aead_mac_pad(&st, pt_len);
     }
+    aead_mac_final(&st, aad_len, pt_len, tag);
+}
+
+/* Seal for short messages: key block and data blocks from one pass. */
+static void aead_seal_small(const chacha20_ctx_t *ctx, const uint8_t *pt,
+                            size_t pt_len, const uint8_t *aad, size_t aad_len,
+                            uint8_t *ct, uint8_t tag[16])
+{
+    uint8_t keystream[4 * 64];
 
-    return compute_poly1305_tag(poly_key, ct, pt_len, aad, aad_len, tag);
+    aead_small_keystream(ctx, 1 + (pt_len + 63) / 64, keystream);
+    aead_seal_keystream(keystream, pt, pt_len, aad, aad_len, ct, tag);
+}
+
+/*
+ * Open for short messages; returns whether the tag matched. The plaintext
+ * is only written once the tag has been checked.
+ */
+static int aead_open_small(const chacha20_ctx_t *ctx, const uint8_t *ct,
+                           size_t ct_len, const uint8_t *aad, size_t aad_len,
+                           const uint8_t tag[16], uint8_t *pt)
+{
+    uint8_t keystream[4 * 64];
+    uint8_t expected_tag[16];
+    poly1305_state_t st;
+
+    aead_small_keystream(ctx, 1 + (ct_len + 63) / 64, keystream);
+
+    aead_mac_init(&st, keystream, aad, aad_len);
+    if (ct_len) {
+        poly1305_update(&st, ct, ct_len);
+        aead_mac_pad(&st, ct_len);
+    }
+    aead_mac_final(&st, aad_len, ct_len, expected_tag);
+
+    if (memcmp(expected_tag, tag, 16) != 0) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < ct_len; i++) {
+        pt[i] = ct[i] ^ keystream[64 + i];
+    }
+
+    return 1;
+}
+
+/* Seals one message with a context already holding its key and nonce. */
+static int aead_seal(chacha20_ctx_t *ctx, const uint8_t *pt, size_t pt_len,
+                     const uint8_t *aad, size_t aad_len, uint8_t *ct,
+                     uint8_t tag[16])
+{
+    uint8_t poly_key[32];
+    poly1305_state_t st;
+
+    if (pt_len <= AEAD_SMALL_MAX_LEN) {
+        aead_seal_small(ctx, pt, pt_len, aad, aad_len, ct, tag);
+        return 0;
+    }
+
+    if ((uint64_t)pt_len > AEAD_MAX_LEN) {
+        return 1;
+    }
+
+    aead_poly_key(ctx, poly_key);
+    aead_mac_init(&st, poly_key, aad, aad_len);
+
+    aead_seal_span(ctx, &st, pt, pt_len, ct);
+
+    aead_mac_pad(&st, pt_len);
+    aead_mac_final(&st, aad_len, pt_len, tag);
+
+    return 0;
+}
+
+/* Opens one message with a context already holding its key and nonce. */
+static int aead_open(chacha20_ctx_t *ctx, const uint8_t *ct, size_t ct_len,
+                     const uint8_t *aad, size_t aad_len, const uint8_t tag[16],
+                     uint8_t *pt)
+{
+    uint8_t poly_key[32];
+    uint8_t expected_tag[16];
+    poly1305_state_t st;
+
+    if (ct_len <= AEAD_SMALL_MAX_LEN) {
+        if (!aead_open_small(ctx, ct, ct_len, aad, aad_len, tag, pt)) {
+            /* Forgery detected: nothing was written, but keep the contract. */
+            if (ct_len > 0) {
+                wipe(pt, ct_len);
+            }
+            return -1;
+        }
+        return 0;
+    }
+
+    if ((uint64_t)ct_len > AEAD_MAX_LEN) {
+        return 1;
+    }
+
+    aead_poly_key(ctx, poly_key);
+    aead_mac_init(&st, poly_key, aad, aad_len);
+
+    aead_open_span(ctx, &st, ct, ct_len, pt);
+
+    aead_mac_pad(&st, ct_len);
+    aead_mac_final(&st, aad_len, ct_len, expected_tag);
+
+    if (memcmp(expected_tag, tag, 16) != 0) {
+        /* Forgery detected: never release unauthenticated plaintext. */
+        if (ct_len > 0) {
+            wipe(pt, ct_len);
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+int chacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t iv[8],
+                              const uint8_t constant[4], const uint8_t *pt,
+                              size_t pt_len, const uint8_t *aad, size_t aad_len,
+                              uint8_t *ct, uint8_t tag[16])
+{
+    uint8_t nonce[12];
+    chacha20_ctx_t ctx;
+
+    aead_nonce(nonce, iv, constant);
+    chacha20_ctx_init(&ctx, key, nonce);
+
+    return aead_seal(&ctx, pt, pt_len, aad, aad_len, ct, tag);
 }
 
 
@@ -81,33 +305,550 @@ int chacha20_poly1305_decrypt(const uint8_t key[32],  const uint8_t iv[8],
                               const uint8_t constant[4], const uint8_t *ct,
                               size_t ct_len, const uint8_t *aad, size_t aad_len,
                               const uint8_t tag[16], uint8_t *pt)
+{
+    uint8_t nonce[12];
+    chacha20_ctx_t ctx;
+
+    aead_nonce(nonce, iv, constant);
+    chacha20_ctx_init(&ctx, key, nonce);
+
+    return aead_open(&ctx, ct, ct_len, aad, aad_len, tag, pt);
+}
+
+int chacha20_poly1305_encrypt_ctx(const chacha20_ctx_t *key_ctx, const uint8_t iv[8],
+                                  const uint8_t constant[4], const uint8_t *pt,
+                                  size_t pt_len, const uint8_t *aad, size_t aad_len,
+                                  uint8_t *ct, uint8_t tag[16])
+{
+    uint8_t nonce[12];
+    chacha20_ctx_t ctx = *key_ctx;
+
+    aead_nonce(nonce, iv, constant);
+    chacha20_ctx_set_nonce(&ctx, nonce);
+
+    int ret = aead_seal(&ctx, pt, pt_len, aad, aad_len, ct, tag);
+    wipe(&ctx, sizeof(ctx));
+
+    return ret;
+}
+
+int chacha20_poly1305_decrypt_ctx(const chacha20_ctx_t *key_ctx, const uint8_t iv[8],
+                                  const uint8_t constant[4], const uint8_t *ct,
+                                  size_t ct_len, const uint8_t *aad, size_t aad_len,
+                                  const uint8_t tag[16], uint8_t *pt)
+{
+    uint8_t nonce[12];
+    chacha20_ctx_t ctx = *key_ctx;
+
+    aead_nonce(nonce, iv, constant);
+    chacha20_ctx_set_nonce(&ctx, nonce);
+
+    int ret = aead_open(&ctx, ct, ct_len, aad, aad_len, tag, pt);
+    wipe(&ctx, sizeof(ctx));
+
+    return ret;
+}
+
+/* Most tasks a parallel call splits into; one partial MAC each, on the stack. */
+#define AEAD_PARALLEL_MAX_TASKS 128
+
+/* One contiguous counter range per task, with its own partial MAC. */
+struct aead_parallel_job {
+    chacha20_ctx_t ctx;         /* Context at block 1 */
+    const uint8_t *poly_key;
+    const uint8_t *in;
+    uint8_t *out;
+    size_t length;
+    size_t chunk;               /* Bytes per task, a multiple of 64 */
+    poly1305_state_t *parts;    /* Partial MAC of each task, from h = 0 */
+    void (*span)(chacha20_ctx_t *, poly1305_state_t *,
+                 const uint8_t *, size_t, uint8_t *);
+};
+
+static void aead_parallel_task(void *arg, size_t index)
+{
+    const struct aead_parallel_job *job = arg;
+    size_t offset = index * job->chunk;
+    size_t length = job->length - offset;
+    if (length > job->chunk) {
+        length = job->chunk;
+    }
+
+    chacha20_ctx_t ctx = job->ctx;
+    chacha20_ctx_set_counter(&ctx, 1 + (uint32_t)(offset / 64));
+
+    poly1305_state_t *part = &job->parts[index];
+    poly1305_init(part, job->poly_key);
+    job->span(&ctx, part, job->in + offset, length, job->out + offset);
+
+    /* Only the last task can end mid-block; pad it like the serial MAC does. */
+    aead_mac_pad(part, length);
+}
+
+/*
+ * Runs the cipher and MAC over the message on the thread pool and joins the
+ * partial MACs into `st`, which holds the MAC of the AAD on entry. Returns 0
+ * without touching anything if the message is too short to split.
+ */
+static int aead_parallel(chacha20_ctx_t *ctx, poly1305_state_t *st,
+                         const uint8_t poly_key[32], const uint8_t *in,
+                         size_t length, uint8_t *out,
+                         void (*span)(chacha20_ctx_t *, poly1305_state_t *,
+                                      const uint8_t *, size_t, uint8_t *),
+                         const chacha20_parallel_opts_t *opts)
+{
+    unsigned int workers = opts && opts->workers ? opts->workers : thread_pool_cpu_count();
+    size_t min_chunk = opts && opts->min_chunk ? opts->min_chunk
+                                               : CHACHA20_PARALLEL_MIN_CHUNK;
+
+    size_t tasks = length / min_chunk;
+    if (tasks > workers) {
+        tasks = workers;
+    }
+    if (tasks > AEAD_PARALLEL_MAX_TASKS) {
+        tasks = AEAD_PARALLEL_MAX_TASKS;
+    }
+    if (tasks <= 1) {
+        return 0;
+    }
+
+    poly1305_state_t parts[AEAD_PARALLEL_MAX_TASKS];
+    struct aead_parallel_job job = {
+        .ctx = *ctx,
+        .poly_key = poly_key,
+        .in = in,
+        .out = out,
+        .length = length,
+        /* Split on block boundaries so every task starts on a fresh counter. */
+        .chunk = ((length + tasks - 1) / tasks + 63) & ~(size_t)63,
+        .parts = parts,
+        .span = span,
+    };
+
+    tasks = (length + job.chunk - 1) / job.chunk;
+    thread_pool_run(tasks, aead_parallel_task, &job, workers);
+
+    for (size_t i = 0; i < tasks; i++) {
+        size_t part_len = i + 1 < tasks ? job.chunk : length - i * job.chunk;
+        poly1305_combine(st, &parts[i], (part_len + 15) / 16);
+    }
+
+    return 1;
+}
+
+int chacha20_poly1305_encrypt_parallel(const uint8_t key[32], const uint8_t iv[8],
+                                       const uint8_t constant[4], const uint8_t *pt,
+                                       size_t pt_len, const uint8_t *aad, size_t aad_len,
+                                       uint8_t *ct, uint8_t tag[16],
+                                       const chacha20_parallel_opts_t *opts)
+{
+    uint8_t poly_key[32];
+    chacha20_ctx_t ctx;
+    poly1305_state_t st;
+
+    if ((uint64_t)pt_len > AEAD_MAX_LEN) {
+        return 1;
+    }
+
+    aead_setup(&ctx, key, iv, constant, poly_key);
+    aead_mac_init(&st, poly_key, aad, aad_len);
+
+    if (!aead_parallel(&ctx, &st, poly_key, pt, pt_len, ct, aead_seal_span, opts)) {
+        aead_seal_span(&ctx, &st, pt, pt_len, ct);
+        aead_mac_pad(&st, pt_len);
+    }
+
+    aead_mac_final(&st, aad_len, pt_len, tag);
+
+    return 0;
+}
+
+int chacha20_poly1305_decrypt_parallel(const uint8_t key[32], const uint8_t iv[8],
+                                       const uint8_t constant[4], const uint8_t *ct,
+                                       size_t ct_len, const uint8_t *aad, size_t aad_len,
+                                       const uint8_t tag[16], uint8_t *pt,
+                                       const chacha20_parallel_opts_t *opts)
 {
     uint8_t poly_key[32];
     uint8_t expected_tag[16];
-    uint8_t nonce[12];
+    chacha20_ctx_t ctx;
+    poly1305_state_t st;
 
-    for (int i = 0; i < 4; i++) {
-        nonce[i] = constant[i];
+    if ((uint64_t)ct_len > AEAD_MAX_LEN) {
+        return 1;
     }
 
-    for (int i = 0; i < 8; i++) {
-        nonce[4 + i] = iv[i];
+    aead_setup(&ctx, key, iv, constant, poly_key);
+    aead_mac_init(&st, poly_key, aad, aad_len);
+
+    if (!aead_parallel(&ctx, &st, poly_key, ct, ct_len, pt, aead_open_span, opts)) {
+        aead_open_span(&ctx, &st, ct, ct_len, pt);
+        aead_mac_pad(&st, ct_len);
+    }
+
+    aead_mac_final(&st, aad_len, ct_len, expected_tag);
+
+    if (memcmp(expected_tag, tag, 16) != 0) {
+        /* Forgery detected: never release unauthenticated plaintext. */
+        if (ct_len > 0) {
+            wipe(pt, ct_len);
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Sums iovec lengths, saturating at SIZE_MAX. */
+static size_t iov_total(const struct iovec *iov, size_t iovcnt)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > SIZE_MAX - total) {
+            return SIZE_MAX;
+        }
+        total += iov[i].iov_len;
+    }
+
+    return total;
+}
+
+/* Starts the MAC over a scattered AAD. */
+static void aead_mac_initv(poly1305_state_t *st, const uint8_t poly_key[32],
+                           const struct iovec *aad, size_t aad_cnt, size_t aad_len)
+{
+    poly1305_init(st, poly_key);
+
+    for (size_t i = 0; i < aad_cnt; i++) {
+        if (aad[i].iov_len) {
+            poly1305_update(st, aad[i].iov_base, aad[i].iov_len);
+        }
+    }
+
+    aead_mac_pad(st, aad_len);
+}
+
+/*
+ * Walks the input and output vectors in step, handing every overlapping
+ * piece to `span`. The two sides may be fragmented differently; the cipher
+ * and MAC states carry partial blocks from one piece to the next.
+ */
+static void aead_walkv(chacha20_ctx_t *ctx, poly1305_state_t *st,
+                       const struct iovec *in, size_t in_cnt,
+                       const struct iovec *out, size_t out_cnt,
+                       void (*span)(chacha20_ctx_t *, poly1305_state_t *,
+                                    const uint8_t *, size_t, uint8_t *))
+{
+    size_t i = 0, j = 0, in_off = 0, out_off = 0;
+
+    while (i < in_cnt && j < out_cnt) {
+        size_t in_left = in[i].iov_len - in_off;
+        size_t out_left = out[j].iov_len - out_off;
+        size_t n = in_left < out_left ? in_left : out_left;
+
+        if (n) {
+            span(ctx, st, (const uint8_t *)in[i].iov_base + in_off, n,
+                 (uint8_t *)out[j].iov_base + out_off);
+        }
+
+        in_off += n;
+        out_off += n;
+        if (in_off == in[i].iov_len) {
+            i++;
+            in_off = 0;
+        }
+        if (out_off == out[j].iov_len) {
+            j++;
+            out_off = 0;
+        }
     }
+}
 
-    poly1305_key_gen(key, nonce, poly_key);
+int chacha20_poly1305_encryptv(const uint8_t key[32], const uint8_t iv[8],
+                               const uint8_t constant[4],
+                               const struct iovec *aad, size_t aad_cnt,
+                               const struct iovec *pt, size_t pt_cnt,
+                               const struct iovec *ct, size_t ct_cnt,
+                               uint8_t tag[16])
+{
+    uint8_t poly_key[32];
+    chacha20_ctx_t ctx;
+    poly1305_state_t st;
 
-    int ret = compute_poly1305_tag(poly_key, ct, ct_len, aad, aad_len, expected_tag);
-    if (ret != 0) {
-        return ret; /* Allocation failed. */
+    size_t aad_len = iov_total(aad, aad_cnt);
+    size_t pt_len = iov_total(pt, pt_cnt);
+
+    if ((uint64_t)pt_len > AEAD_MAX_LEN || iov_total(ct, ct_cnt) < pt_len) {
+        return 1;
     }
 
+    aead_setup(&ctx, key, iv, constant, poly_key);
+    aead_mac_initv(&st, poly_key, aad, aad_cnt, aad_len);
+    aead_walkv(&ctx, &st, pt, pt_cnt, ct, ct_cnt, aead_seal_span);
+    aead_mac_pad(&st, pt_len);
+    aead_mac_final(&st, aad_len, pt_len, tag);
+
+    return 0;
+}
+
+int chacha20_poly1305_decryptv(const uint8_t key[32], const uint8_t iv[8],
+                               const uint8_t constant[4],
+                               const struct iovec *aad, size_t aad_cnt,
+                               const struct iovec *ct, size_t ct_cnt,
+                               const uint8_t tag[16],
+                               const struct iovec *pt, size_t pt_cnt)
+{
+    uint8_t poly_key[32];
+    uint8_t expected_tag[16];
+    chacha20_ctx_t ctx;
+    poly1305_state_t st;
+
+    size_t aad_len = iov_total(aad, aad_cnt);
+    size_t ct_len = iov_total(ct, ct_cnt);
+
+    if ((uint64_t)ct_len > AEAD_MAX_LEN || iov_total(pt, pt_cnt) < ct_len) {
+        return 1;
+    }
+
+    aead_setup(&ctx, key, iv, constant, poly_key);
+    aead_mac_initv(&st, poly_key, aad, aad_cnt, aad_len);
+    aead_walkv(&ctx, &st, ct, ct_cnt, pt, pt_cnt, aead_open_span);
+    aead_mac_pad(&st, ct_len);
+    aead_mac_final(&st, aad_len, ct_len, expected_tag);
+
     if (memcmp(expected_tag, tag, 16) != 0) {
-        return -1; /* Forgery detected, aborting. */
+        /* Forgery detected: wipe the ct_len bytes written across pt. */
+        size_t left = ct_len;
+        for (size_t i = 0; i < pt_cnt && left; i++) {
+            size_t n = pt[i].iov_len < left ? pt[i].iov_len : left;
+            if (n) {
+                wipe(pt[i].iov_base, n);
+            }
+            left -= n;
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Batch sealing spreads the blocks of many short packets across the lanes
+ * of the multi-state kernels, up to the widest kernel's lane count per call.
+ * Packets this long already fill the lanes on their own and take the
+ * single-message path.
+ */
+#define AEAD_BATCH_LANES 16
+#define AEAD_BATCH_MAX_LEN 1024
+
+int chacha20_poly1305_encrypt_batch(const uint8_t key[32],
+                                    const uint8_t constant[4],
+                                    const chacha20_poly1305_packet_t *packets,
+                                    size_t count)
+{
+    uint32_t states[AEAD_BATCH_LANES][16];
+    uint8_t keystream[AEAD_BATCH_LANES * 64];
+    size_t job_packet[AEAD_BATCH_LANES];
+    uint32_t job_block[AEAD_BATCH_LANES];
+    uint8_t nonce[12] = {0};
+    chacha20_ctx_t ctx;
+    poly1305_state_t st;
+
+    for (size_t p = 0; p < count; p++) {
+        if ((uint64_t)packets[p].pt_len > AEAD_MAX_LEN) {
+            return 1;
+        }
+    }
+
+    memcpy(nonce, constant, 4);
+    chacha20_ctx_init(&ctx, key, nonce);
+
+    /* Job cursor: block `block` of packet `p`, where block 0 is the MAC key. */
+    size_t p = 0;
+    uint32_t block = 0;
+
+    while (p < count) {
+        size_t jobs = 0;
+
+        while (jobs < AEAD_BATCH_LANES && p < count) {
+            const chacha20_poly1305_packet_t *pkt = &packets[p];
+
+            if (pkt->pt_len >= AEAD_BATCH_MAX_LEN) {
+                chacha20_poly1305_encrypt(key, pkt->iv, constant, pkt->pt, pkt->pt_len,
+                                          pkt->aad, pkt->aad_len, pkt->ct, pkt->tag);
+                p++;
+                continue;
+            }
+
+            if (block == 0) {
+                memcpy(nonce + 4, pkt->iv, 8);
+                chacha20_ctx_set_nonce(&ctx, nonce);
+            }
+            chacha20_ctx_set_counter(&ctx, block);
+            memcpy(states[jobs], ctx.state, sizeof(states[jobs]));
+            job_packet[jobs] = p;
+            job_block[jobs] = block;
+            jobs++;
+
+            if ((size_t)block * 64 >= pkt->pt_len) {
+                p++;
+                block = 0;
+            } else {
+                block++;
+            }
+        }
+
+        chacha20_blocks_multi((const uint32_t (*)[16])states, jobs, keystream);
+
+        /* Jobs are in packet order, so one MAC state follows them through. */
+        for (size_t j = 0; j < jobs; j++) {
+            const chacha20_poly1305_packet_t *pkt = &packets[job_packet[j]];
+            const uint8_t *ks = keystream + 64 * j;
+            size_t end = (size_t)job_block[j] * 64;   /* Bytes covered so far */
+
+            if (job_block[j] == 0) {
+                aead_mac_init(&st, ks, pkt->aad, pkt->aad_len);
+            } else {
+                size_t start = end - 64;
+                size_t n = pkt->pt_len - start < 64 ? pkt->pt_len - start : 64;
+
+                for (size_t i = 0; i < n; i++) {
+                    pkt->ct[start + i] = pkt->pt[start + i] ^ ks[i];
+                }
+                poly1305_update(&st, pkt->ct + start, n);
+            }
+
+            if (end >= pkt->pt_len) {
+                aead_mac_pad(&st, pkt->pt_len);
+                aead_mac_final(&st, pkt->aad_len, pkt->pt_len, pkt->tag);
+            }
+        }
+    }
+
+    return 0;
+}
+
+void chacha20_poly1305_session_init(chacha20_poly1305_session_t *session,
+                                    const uint8_t key[32],
+                                    const uint8_t constant[4])
+{
+    static const uint8_t zero_iv[8] = {0};
+
+    aead_nonce(session->nonce, zero_iv, constant);
+    chacha20_ctx_init(&session->ctx, key, session->nonce);
+    session->seq = 0;
+    session->exhausted = 0;
+}
+
+/* Points the session context at the record with the current sequence number. */
+static void session_record_nonce(chacha20_poly1305_session_t *session)
+{
+    for (int i = 0; i < 8; i++) {
+        session->nonce[4 + i] = (uint8_t)(session->seq >> (8 * i));
+    }
+
+    chacha20_ctx_set_nonce(&session->ctx, session->nonce);
+}
+
+/* Consumes the current sequence number; the last IV is never followed by a
+ * wrapped one. */
+static void session_advance(chacha20_poly1305_session_t *session)
+{
+    if (session->seq == UINT64_MAX) {
+        session->exhausted = 1;
+    } else {
+        session->seq++;
+    }
+}
+
+int chacha20_poly1305_seal(chacha20_poly1305_session_t *session,
+                           const uint8_t *pt, size_t pt_len,
+                           const uint8_t *aad, size_t aad_len,
+                           uint8_t *ct, uint8_t tag[16])
+{
+    if (session->exhausted) {
+        return 1;
     }
 
-    if (ct && ct_len > 0) {
-        chacha20_apply(key, 1, nonce, ct, ct_len, pt);
+    session_record_nonce(session);
+    if (aead_seal(&session->ctx, pt, pt_len, aad, aad_len, ct, tag) != 0) {
+        return 1;
     }
+    session_advance(session);
 
     return 0;
+}
+
+int chacha20_poly1305_open(chacha20_poly1305_session_t *session,
+                           const uint8_t *ct, size_t ct_len,
+                           const uint8_t *aad, size_t aad_len,
+                           const uint8_t tag[16], uint8_t *pt)
+{
+    if (session->exhausted) {
+        return 1;
+    }
+
+    session_record_nonce(session);
+    int ret = aead_open(&session->ctx, ct, ct_len, aad, aad_len, tag, pt);
+    if (ret == 0) {
+        session_advance(session);
+    }
+
+    return ret;
+}
+
+int chacha20_poly1305_seal_keystream(chacha20_poly1305_session_t *session,
+                                     const uint8_t *keystream,
+                                     const uint8_t *pt, size_t pt_len,
+                                     const uint8_t *aad, size_t aad_len,
+                                     uint8_t *ct, uint8_t tag[16])
+{
+    if (session->exhausted) {
+        return 1;
+    }
+
+    aead_seal_keystream(keystream, pt, pt_len, aad, aad_len, ct, tag);
+    session_advance(session);
+
+    return 0;
+}
+
+void chacha20_poly1305_session_wipe(chacha20_poly1305_session_t *session)
+{
+    wipe(session, sizeof(*session));
+}
+
+int xchacha20_poly1305_encrypt(const uint8_t key[32], const uint8_t nonce[24],
+                               const uint8_t *pt, size_t pt_len,
+                               const uint8_t *aad, size_t aad_len,
+                               uint8_t *ct, uint8_t tag[16])
+{
+    static const uint8_t constant[4] = {0};
+    uint8_t subkey[32];
+
+    hchacha20(key, nonce, subkey);
+
+    int ret = chacha20_poly1305_encrypt(subkey, nonce + 16, constant, pt, pt_len,
+                                        aad, aad_len, ct, tag);
+    wipe(subkey, sizeof(subkey));
+
+    return ret;
+}
+
+int xchacha20_poly1305_decrypt(const uint8_t key[32], const uint8_t nonce[24],
+                               const uint8_t *ct, size_t ct_len,
+                               const uint8_t *aad, size_t aad_len,
+                               const uint8_t tag[16], uint8_t *pt)
+{
+    static const uint8_t constant[4] = {0};
+    uint8_t subkey[32];
+
+    hchacha20(key, nonce, subkey);
+
+    int ret = chacha20_poly1305_decrypt(subkey, nonce + 16, constant, ct, ct_len,
+                                        aad, aad_len, tag, pt);
+    wipe(subkey, sizeof(subkey));
+
+    return ret;
 }
\ No newline at end of file
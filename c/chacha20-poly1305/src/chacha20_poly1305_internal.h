@@ -0,0 +1,35 @@
+#ifndef __CHACHA20_POLY1305_INTERNAL__
+#define __CHACHA20_POLY1305_INTERNAL__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "chacha20_poly1305.h"
+
+/* Largest payload the 32-bit block counter can cover after block 0. */
+#define AEAD_MAX_LEN ((((uint64_t)1 << 32) - 1) * 64)
+
+/**
+ * @brief Seals the next record of a session from precomputed keystream.
+ *
+ * `keystream` holds blocks 0, 1, ... of the record's nonce (constant | IV
+ * of the session's current sequence number): block 0 yields the Poly1305
+ * key and the following blocks cover pt_len bytes. The result is the same
+ * as chacha20_poly1305_seal(), and the IV advances the same way.
+ *
+ * @param[in,out] session   The session.
+ * @param[in]     keystream 64 * (1 + ceil(pt_len / 64)) bytes of keystream.
+ * @param[in]     pt        Pointer to the plaintext data.
+ * @param[in]     pt_len    Length of the plaintext in bytes.
+ * @param[in]     aad       Pointer to the Additional Authenticated Data (AAD).
+ * @param[in]     aad_len   Length of the AAD in bytes.
+ * @param[out]    ct        The output buffer for the encrypted data.
+ * @param[out]    tag       The 16-byte output buffer for the authentication tag.
+ * @return                  0 on success, 1 if every IV has been used.
+ */
+int chacha20_poly1305_seal_keystream(chacha20_poly1305_session_t *session,
+                                     const uint8_t *keystream,
+                                     const uint8_t *pt, size_t pt_len,
+                                     const uint8_t *aad, size_t aad_len,
+                                     uint8_t *ct, uint8_t tag[16]);
+
+#endif /* __CHACHA20_POLY1305_INTERNAL__ */
@@ -0,0 +1,352 @@
+#include "chacha20_poly1305_keycache.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chacha20_poly1305.h"
+
+#define KEYCACHE_DEFAULT_SHARDS 16
+/* End of a bucket chain. */
+#define KEYCACHE_NIL UINT32_MAX
+
+struct keycache_entry {
+    uint32_t state[16];     /* Expanded key with a zero nonce and counter */
+    uint64_t key_id;
+    uint32_t next;          /* Next entry in the same bucket */
+    uint8_t used;
+    uint8_t referenced;     /* CLOCK bit: set on use, cleared as the hand passes */
+};
+
+/* Aligned to a cache line so neighbouring shard locks do not false-share. */
+struct keycache_shard {
+    _Alignas(64) pthread_mutex_t lock;
+    struct keycache_entry *entries;
+    uint32_t *buckets;      /* Head entry of each bucket chain */
+    size_t hand;            /* CLOCK hand over entries */
+    size_t count;
+    uint64_t generation;    /* Bumped by every invalidation */
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+struct chacha20_keycache {
+    struct keycache_shard *shards;
+    size_t shard_mask;
+    size_t shard_entries;   /* Capacity of each shard */
+    size_t bucket_mask;
+    chacha20_keycache_load_fn load;
+    void *arg;
+};
+
+/* Writes zeros the compiler cannot drop as dead stores. */
+static void wipe(void *p, size_t len)
+{
+    volatile uint8_t *v = p;
+
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+/* splitmix64 finalizer: low bits pick the shard, high bits the bucket. */
+static uint64_t keycache_hash(uint64_t key_id)
+{
+    key_id ^= key_id >> 30;
+    key_id *= 0xbf58476d1ce4e5b9ULL;
+    key_id ^= key_id >> 27;
+    key_id *= 0x94d049bb133111ebULL;
+    key_id ^= key_id >> 31;
+
+    return key_id;
+}
+
+static size_t round_up_pow2(size_t n)
+{
+    size_t p = 1;
+
+    while (p < n) {
+        p <<= 1;
+    }
+
+    return p;
+}
+
+static uint32_t *keycache_bucket(const chacha20_keycache_t *cache,
+                                 struct keycache_shard *shard, uint64_t hash)
+{
+    return &shard->buckets[(hash >> 32) & cache->bucket_mask];
+}
+
+static uint32_t keycache_find(const chacha20_keycache_t *cache,
+                              struct keycache_shard *shard, uint64_t hash,
+                              uint64_t key_id)
+{
+    uint32_t idx = *keycache_bucket(cache, shard, hash);
+
+    while (idx != KEYCACHE_NIL && shard->entries[idx].key_id != key_id) {
+        idx = shard->entries[idx].next;
+    }
+
+    return idx;
+}
+
+/* Unlinks an entry from its bucket and wipes it. */
+static void keycache_remove(const chacha20_keycache_t *cache,
+                            struct keycache_shard *shard, uint32_t idx)
+{
+    struct keycache_entry *e = &shard->entries[idx];
+    uint32_t *link = keycache_bucket(cache, shard, keycache_hash(e->key_id));
+
+    while (*link != idx) {
+        link = &shard->entries[*link].next;
+    }
+    *link = e->next;
+
+    wipe(e, sizeof(*e));
+    shard->count--;
+}
+
+/* Returns a free entry, evicting the first one the CLOCK hand finds unused. */
+static uint32_t keycache_victim(const chacha20_keycache_t *cache,
+                                struct keycache_shard *shard)
+{
+    for (;;) {
+        uint32_t idx = (uint32_t)shard->hand;
+        struct keycache_entry *e = &shard->entries[idx];
+
+        shard->hand = (shard->hand + 1) % cache->shard_entries;
+
+        if (!e->used) {
+            return idx;
+        }
+        if (e->referenced) {
+            e->referenced = 0;
+            continue;
+        }
+
+        keycache_remove(cache, shard, idx);
+        shard->evictions++;
+
+        return idx;
+    }
+}
+
+chacha20_keycache_t *chacha20_keycache_create(size_t capacity, size_t shards,
+                                              chacha20_keycache_load_fn load,
+                                              void *arg)
+{
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    shards = round_up_pow2(shards ? shards : KEYCACHE_DEFAULT_SHARDS);
+    if (shards > capacity) {
+        shards = round_up_pow2(capacity);
+    }
+
+    const size_t shard_entries = (capacity + shards - 1) / shards;
+    const size_t buckets = round_up_pow2(shard_entries);
+
+    if (shard_entries >= KEYCACHE_NIL) {
+        return NULL;
+    }
+
+    chacha20_keycache_t *cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->shards = aligned_alloc(_Alignof(struct keycache_shard),
+                                  shards * sizeof(struct keycache_shard));
+    if (cache->shards == NULL) {
+        free(cache);
+        return NULL;
+    }
+    memset(cache->shards, 0, shards * sizeof(struct keycache_shard));
+
+    cache->shard_mask = shards - 1;
+    cache->shard_entries = shard_entries;
+    cache->bucket_mask = buckets - 1;
+    cache->load = load;
+    cache->arg = arg;
+
+    for (size_t s = 0; s < shards; s++) {
+        struct keycache_shard *shard = &cache->shards[s];
+
+        shard->entries = calloc(shard_entries, sizeof(*shard->entries));
+        shard->buckets = malloc(buckets * sizeof(*shard->buckets));
+        if (shard->entries == NULL || shard->buckets == NULL ||
+            pthread_mutex_init(&shard->lock, NULL) != 0) {
+            free(shard->entries);
+            free(shard->buckets);
+            /* Shards 0..s-1 are fully set up and still empty. */
+            for (size_t i = 0; i < s; i++) {
+                pthread_mutex_destroy(&cache->shards[i].lock);
+                free(cache->shards[i].entries);
+                free(cache->shards[i].buckets);
+            }
+            free(cache->shards);
+            free(cache);
+            return NULL;
+        }
+        memset(shard->buckets, 0xff, buckets * sizeof(*shard->buckets));
+    }
+
+    return cache;
+}
+
+void chacha20_keycache_destroy(chacha20_keycache_t *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    for (size_t s = 0; s <= cache->shard_mask; s++) {
+        struct keycache_shard *shard = &cache->shards[s];
+
+        wipe(shard->entries, cache->shard_entries * sizeof(*shard->entries));
+        pthread_mutex_destroy(&shard->lock);
+        free(shard->entries);
+        free(shard->buckets);
+    }
+
+    free(cache->shards);
+    free(cache);
+}
+
+int chacha20_keycache_get(chacha20_keycache_t *cache, uint64_t key_id,
+                          chacha20_ctx_t *ctx)
+{
+    static const uint8_t zero_nonce[12] = {0};
+    const uint64_t hash = keycache_hash(key_id);
+    struct keycache_shard *shard = &cache->shards[hash & cache->shard_mask];
+    uint8_t key[32];
+
+    pthread_mutex_lock(&shard->lock);
+
+    uint32_t idx = keycache_find(cache, shard, hash, key_id);
+    if (idx != KEYCACHE_NIL) {
+        struct keycache_entry *e = &shard->entries[idx];
+
+        e->referenced = 1;
+        memcpy(ctx->state, e->state, sizeof(ctx->state));
+        shard->hits++;
+        pthread_mutex_unlock(&shard->lock);
+
+        chacha20_ctx_set_counter(ctx, 0);
+        return 0;
+    }
+
+    shard->misses++;
+    const uint64_t generation = shard->generation;
+    pthread_mutex_unlock(&shard->lock);
+
+    /* The loader may block, so it runs with the shard unlocked. */
+    if (cache->load(cache->arg, key_id, key) != 0) {
+        wipe(key, sizeof(key));
+        return 1;
+    }
+    chacha20_ctx_init(ctx, key, zero_nonce);
+    wipe(key, sizeof(key));
+
+    pthread_mutex_lock(&shard->lock);
+
+    /*
+     * Another thread may have loaded the same key in the meantime, or
+     * invalidated keys of this shard, in which case the loaded key may be
+     * the old one: it serves this call but is not cached.
+     */
+    if (shard->generation == generation &&
+        keycache_find(cache, shard, hash, key_id) == KEYCACHE_NIL) {
+        uint32_t *bucket = keycache_bucket(cache, shard, hash);
+
+        idx = keycache_victim(cache, shard);
+        struct keycache_entry *e = &shard->entries[idx];
+
+        memcpy(e->state, ctx->state, sizeof(e->state));
+        e->key_id = key_id;
+        e->used = 1;
+        e->referenced = 1;
+        e->next = *bucket;
+        *bucket = idx;
+        shard->count++;
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+
+    return 0;
+}
+
+void chacha20_keycache_invalidate(chacha20_keycache_t *cache, uint64_t key_id)
+{
+    const uint64_t hash = keycache_hash(key_id);
+    struct keycache_shard *shard = &cache->shards[hash & cache->shard_mask];
+
+    pthread_mutex_lock(&shard->lock);
+
+    /* Loads in flight on this shard started before the invalidation. */
+    shard->generation++;
+
+    uint32_t idx = keycache_find(cache, shard, hash, key_id);
+    if (idx != KEYCACHE_NIL) {
+        keycache_remove(cache, shard, idx);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+}
+
+void chacha20_keycache_stats(chacha20_keycache_t *cache,
+                             chacha20_keycache_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = (cache->shard_mask + 1) * cache->shard_entries;
+
+    for (size_t s = 0; s <= cache->shard_mask; s++) {
+        struct keycache_shard *shard = &cache->shards[s];
+
+        pthread_mutex_lock(&shard->lock);
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->evictions += shard->evictions;
+        stats->entries += shard->count;
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+int chacha20_keycache_encrypt(chacha20_keycache_t *cache, uint64_t key_id,
+                              const uint8_t iv[8], const uint8_t constant[4],
+                              const uint8_t *pt, size_t pt_len,
+                              const uint8_t *aad, size_t aad_len,
+                              uint8_t *ct, uint8_t tag[16])
+{
+    chacha20_ctx_t ctx;
+
+    if (chacha20_keycache_get(cache, key_id, &ctx) != 0) {
+        return 1;
+    }
+
+    int ret = chacha20_poly1305_encrypt_ctx(&ctx, iv, constant, pt, pt_len,
+                                            aad, aad_len, ct, tag);
+    wipe(&ctx, sizeof(ctx));
+
+    return ret;
+}
+
+int chacha20_keycache_decrypt(chacha20_keycache_t *cache, uint64_t key_id,
+                              const uint8_t iv[8], const uint8_t constant[4],
+                              const uint8_t *ct, size_t ct_len,
+                              const uint8_t *aad, size_t aad_len,
+                              const uint8_t tag[16], uint8_t *pt)
+{
+    chacha20_ctx_t ctx;
+
+    if (chacha20_keycache_get(cache, key_id, &ctx) != 0) {
+        return 1;
+    }
+
+    int ret = chacha20_poly1305_decrypt_ctx(&ctx, iv, constant, ct, ct_len,
+                                            aad, aad_len, tag, pt);
+    wipe(&ctx, sizeof(ctx));
+
+    return ret;
+}
@@ -0,0 +1,102 @@
+#include "chacha20_poly1305_nonce.h"
+#include <string.h>
+#include "chacha20_poly1305.h"
+
+/* Value of a pool's `next` once every IV has been reserved. */
+#define NONCE_POOL_EXHAUSTED UINT64_MAX
+
+/* Takes the next range from the pool; fails once the IV space runs out. */
+static int nonce_reserve(chacha20_nonce_t *n)
+{
+    chacha20_nonce_pool_t *pool = n->pool;
+
+    if (pool == NULL) {
+        return 1;
+    }
+
+    uint64_t start = atomic_load_explicit(&pool->next, memory_order_relaxed);
+    uint64_t end;
+
+    /*
+     * A CAS rather than fetch_add, so an exhausted pool never wraps. The
+     * range that reaches the top runs through the last IV, so none is lost
+     * and the pool is left on the sentinel.
+     */
+    do {
+        if (start == NONCE_POOL_EXHAUSTED) {
+            return 1;
+        }
+        end = pool->block_ivs < NONCE_POOL_EXHAUSTED - start ?
+              start + pool->block_ivs : NONCE_POOL_EXHAUSTED;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->next, &start, end,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+
+    n->next = start;
+    n->last = end == NONCE_POOL_EXHAUSTED ? UINT64_MAX : end - 1;
+    n->has_range = 1;
+
+    return 0;
+}
+
+void chacha20_nonce_pool_init(chacha20_nonce_pool_t *pool, const uint8_t constant[4],
+                              uint64_t block_ivs)
+{
+    atomic_init(&pool->next, 0);
+    pool->block_ivs = block_ivs ? block_ivs : CHACHA20_NONCE_POOL_BLOCK;
+    memcpy(pool->constant, constant, 4);
+}
+
+void chacha20_nonce_init_worker(chacha20_nonce_t *n, uint32_t worker_id)
+{
+    n->pool = NULL;
+    for (int i = 0; i < 4; i++) {
+        n->constant[i] = (uint8_t)(worker_id >> (8 * i));
+    }
+    n->next = 0;
+    n->last = UINT64_MAX;
+    n->has_range = 1;
+}
+
+void chacha20_nonce_init_pooled(chacha20_nonce_t *n, chacha20_nonce_pool_t *pool)
+{
+    n->pool = pool;
+    memcpy(n->constant, pool->constant, 4);
+    n->next = 0;
+    n->last = 0;
+    n->has_range = 0;
+}
+
+int chacha20_nonce_next(chacha20_nonce_t *n, uint8_t constant[4], uint8_t iv[8])
+{
+    if (!n->has_range && nonce_reserve(n) != 0) {
+        return 1;
+    }
+
+    memcpy(constant, n->constant, 4);
+    for (int i = 0; i < 8; i++) {
+        iv[i] = (uint8_t)(n->next >> (8 * i));
+    }
+
+    if (n->next == n->last) {
+        n->has_range = 0;
+    } else {
+        n->next++;
+    }
+
+    return 0;
+}
+
+int chacha20_nonce_encrypt(chacha20_nonce_t *n, const uint8_t key[32],
+                           uint8_t constant[4], uint8_t iv[8],
+                           const uint8_t *pt, size_t pt_len,
+                           const uint8_t *aad, size_t aad_len,
+                           uint8_t *ct, uint8_t tag[16])
+{
+    if (chacha20_nonce_next(n, constant, iv) != 0) {
+        return 1;
+    }
+
+    return chacha20_poly1305_encrypt(key, iv, constant, pt, pt_len, aad, aad_len,
+                                     ct, tag);
+}
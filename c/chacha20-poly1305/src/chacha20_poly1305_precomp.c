@@ -0,0 +1,260 @@
+#include "chacha20_poly1305_precomp.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chacha20.h"
+#include "chacha20_poly1305_internal.h"
+
+/*
+ * The producer owns `head`, the consumer `tail`; both only grow, and slot
+ * i lives at index i % records. They sit on separate cache lines so the
+ * two threads do not bounce one line on every record.
+ */
+struct chacha20_poly1305_precomp {
+    _Alignas(64) _Atomic uint64_t head;     /* Slots produced */
+    _Alignas(64) _Atomic uint64_t tail;     /* Slots consumed */
+    _Alignas(64) _Atomic uint64_t resync;   /* Lowest IV still worth producing */
+    atomic_int parked;                      /* Producer is waiting for room */
+    atomic_int stop;
+    pthread_mutex_t lock;                   /* Only guards parking */
+    pthread_cond_t wake;
+    pthread_t thread;
+
+    chacha20_ctx_t ctx;                     /* Session key, producer's copy */
+    uint8_t nonce[12];                      /* Session constant | IV */
+    uint64_t start_seq;
+    int start_exhausted;
+
+    size_t records;
+    size_t slot_bytes;                      /* Key block + data blocks */
+    uint64_t *slot_seq;                     /* IV each slot was computed for */
+    uint8_t *keystream;                     /* records * slot_bytes */
+
+    chacha20_poly1305_precomp_stats_t stats;  /* Consumer-side counters */
+};
+
+/* Writes zeros the compiler cannot drop as dead stores. */
+static void wipe(void *p, size_t len)
+{
+    volatile uint8_t *v = p;
+
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+/* Parks the producer until the ring has room or it is told to stop. */
+static void precomp_park(chacha20_poly1305_precomp_t *pc, uint64_t head)
+{
+    pthread_mutex_lock(&pc->lock);
+    atomic_store(&pc->parked, 1);
+
+    /* Re-checked after `parked` is set, so the consumer's wake is not lost. */
+    while (!atomic_load(&pc->stop) &&
+           head - atomic_load(&pc->tail) == pc->records) {
+        pthread_cond_wait(&pc->wake, &pc->lock);
+    }
+
+    atomic_store(&pc->parked, 0);
+    pthread_mutex_unlock(&pc->lock);
+}
+
+/* Fills the ring with the keystream of consecutive IVs. */
+static void *precomp_thread(void *arg)
+{
+    chacha20_poly1305_precomp_t *pc = arg;
+    chacha20_ctx_t ctx = pc->ctx;
+    uint64_t seq = pc->start_seq;
+    int exhausted = pc->start_exhausted;
+
+    while (!atomic_load_explicit(&pc->stop, memory_order_relaxed) && !exhausted) {
+        const uint64_t head = atomic_load_explicit(&pc->head, memory_order_relaxed);
+
+        if (head - atomic_load_explicit(&pc->tail, memory_order_acquire) == pc->records) {
+            precomp_park(pc, head);
+            continue;
+        }
+
+        /* Skip IVs the session has already used without the ring. */
+        const uint64_t resync = atomic_load_explicit(&pc->resync, memory_order_relaxed);
+        if (resync > seq) {
+            seq = resync;
+        }
+
+        uint8_t *ks = pc->keystream + (head % pc->records) * pc->slot_bytes;
+
+        for (int i = 0; i < 8; i++) {
+            pc->nonce[4 + i] = (uint8_t)(seq >> (8 * i));
+        }
+        chacha20_ctx_set_nonce(&ctx, pc->nonce);
+        chacha20_ctx_set_counter(&ctx, 0);
+        memset(ks, 0, pc->slot_bytes);
+        chacha20_ctx_xor(&ctx, ks, pc->slot_bytes, ks);
+        pc->slot_seq[head % pc->records] = seq;
+
+        atomic_store_explicit(&pc->head, head + 1, memory_order_release);
+
+        if (seq == UINT64_MAX) {
+            exhausted = 1;
+        } else {
+            seq++;
+        }
+    }
+
+    wipe(&ctx, sizeof(ctx));
+
+    return NULL;
+}
+
+chacha20_poly1305_precomp_t *chacha20_poly1305_precomp_start(
+    const chacha20_poly1305_session_t *session, size_t records, size_t max_record)
+{
+    if (records < 2 || (uint64_t)max_record > AEAD_MAX_LEN) {
+        return NULL;
+    }
+
+    const size_t slot_bytes = 64 * (1 + (max_record + 63) / 64);
+
+    if (records > SIZE_MAX / slot_bytes) {
+        return NULL;
+    }
+
+    chacha20_poly1305_precomp_t *pc = aligned_alloc(_Alignof(chacha20_poly1305_precomp_t),
+                                                    sizeof(*pc));
+    if (pc == NULL) {
+        return NULL;
+    }
+    memset(pc, 0, sizeof(*pc));
+
+    pc->slot_seq = calloc(records, sizeof(*pc->slot_seq));
+    pc->keystream = calloc(records, slot_bytes);
+    if (pc->slot_seq == NULL || pc->keystream == NULL) {
+        free(pc->slot_seq);
+        free(pc->keystream);
+        free(pc);
+        return NULL;
+    }
+
+    atomic_init(&pc->head, 0);
+    atomic_init(&pc->tail, 0);
+    atomic_init(&pc->resync, 0);
+    atomic_init(&pc->parked, 0);
+    atomic_init(&pc->stop, 0);
+    pc->ctx = session->ctx;
+    memcpy(pc->nonce, session->nonce, sizeof(pc->nonce));
+    pc->start_seq = session->seq;
+    pc->start_exhausted = session->exhausted;
+    pc->records = records;
+    pc->slot_bytes = slot_bytes;
+
+    pthread_mutex_init(&pc->lock, NULL);
+    pthread_cond_init(&pc->wake, NULL);
+
+    if (pthread_create(&pc->thread, NULL, precomp_thread, pc) != 0) {
+        pthread_cond_destroy(&pc->wake);
+        pthread_mutex_destroy(&pc->lock);
+        wipe(&pc->ctx, sizeof(pc->ctx));
+        free(pc->slot_seq);
+        free(pc->keystream);
+        free(pc);
+        return NULL;
+    }
+
+    return pc;
+}
+
+/* Hands a slot back to the producer, waking it once half the ring is free. */
+static void precomp_release(chacha20_poly1305_precomp_t *pc, uint64_t tail)
+{
+    atomic_store(&pc->tail, tail + 1);
+
+    if (atomic_load_explicit(&pc->head, memory_order_relaxed) - (tail + 1) <= pc->records / 2 &&
+        atomic_load(&pc->parked)) {
+        pthread_mutex_lock(&pc->lock);
+        pthread_cond_signal(&pc->wake);
+        pthread_mutex_unlock(&pc->lock);
+    }
+}
+
+int chacha20_poly1305_precomp_seal(chacha20_poly1305_precomp_t *pc,
+                                   chacha20_poly1305_session_t *session,
+                                   const uint8_t *pt, size_t pt_len,
+                                   const uint8_t *aad, size_t aad_len,
+                                   uint8_t *ct, uint8_t tag[16])
+{
+    for (;;) {
+        const uint64_t tail = atomic_load_explicit(&pc->tail, memory_order_relaxed);
+
+        if (tail == atomic_load_explicit(&pc->head, memory_order_acquire)) {
+            break;
+        }
+
+        const uint64_t seq = pc->slot_seq[tail % pc->records];
+        uint8_t *ks = pc->keystream + (tail % pc->records) * pc->slot_bytes;
+
+        if (seq < session->seq) {
+            /* The IV was used by a direct seal, so this is that record's keystream. */
+            wipe(ks, pc->slot_bytes);
+            atomic_store_explicit(&pc->resync, session->seq, memory_order_relaxed);
+            pc->stats.discarded++;
+            precomp_release(pc, tail);
+            continue;
+        }
+
+        if (seq != session->seq || session->exhausted ||
+            pt_len > pc->slot_bytes - 64) {
+            break;
+        }
+
+        chacha20_poly1305_seal_keystream(session, ks, pt, pt_len, aad, aad_len,
+                                         ct, tag);
+        /*
+         * The Poly1305 key would allow forging this record and the data
+         * keystream would reveal its plaintext from the ciphertext, so both
+         * go at once; the rest of the slot was never used.
+         */
+        wipe(ks, 64 + pt_len);
+        pc->stats.precomputed++;
+        precomp_release(pc, tail);
+
+        return 0;
+    }
+
+    pc->stats.inline_seals++;
+
+    return chacha20_poly1305_seal(session, pt, pt_len, aad, aad_len, ct, tag);
+}
+
+size_t chacha20_poly1305_precomp_ready(const chacha20_poly1305_precomp_t *pc)
+{
+    return (size_t)(atomic_load_explicit(&pc->head, memory_order_acquire) -
+                    atomic_load_explicit(&pc->tail, memory_order_relaxed));
+}
+
+void chacha20_poly1305_precomp_stats(const chacha20_poly1305_precomp_t *pc,
+                                     chacha20_poly1305_precomp_stats_t *stats)
+{
+    *stats = pc->stats;
+}
+
+void chacha20_poly1305_precomp_stop(chacha20_poly1305_precomp_t *pc)
+{
+    if (pc == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pc->lock);
+    atomic_store(&pc->stop, 1);
+    pthread_cond_signal(&pc->wake);
+    pthread_mutex_unlock(&pc->lock);
+    pthread_join(pc->thread, NULL);
+
+    pthread_cond_destroy(&pc->wake);
+    pthread_mutex_destroy(&pc->lock);
+    wipe(&pc->ctx, sizeof(pc->ctx));
+    wipe(pc->keystream, pc->records * pc->slot_bytes);
+    free(pc->slot_seq);
+    free(pc->keystream);
+    free(pc);
+}
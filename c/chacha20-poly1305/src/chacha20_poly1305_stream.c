@@ -0,0 +1,115 @@
+#include "chacha20_poly1305_stream.h"
+#include <string.h>
+#include "chacha20.h"
+#include "chacha20_poly1305.h"
+#include "chacha20_rng.h"
+
+/* AAD bytes marking a segment as intermediate or final. */
+#define STREAM_FLAG_MORE  0x00
+#define STREAM_FLAG_FINAL 0x01
+
+/* Zeroes memory through a volatile pointer so the store is not elided. */
+static void wipe(void *p, size_t len)
+{
+    volatile uint8_t *v = p;
+
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+/* Segment i is sealed under IV i; the subkey is unique to the stream. */
+static void stream_iv(uint64_t counter, uint8_t iv[8])
+{
+    for (int i = 0; i < 8; i++) {
+        iv[i] = (uint8_t)(counter >> (8 * i));
+    }
+}
+
+/* Derives the per-stream subkey and resets the segment counter. */
+static void stream_init(chacha20_stream_state_t *st, const uint8_t key[32],
+                        const uint8_t header[CHACHA20_STREAM_HEADER_BYTES])
+{
+    hchacha20(key, header, st->key);
+    st->counter = 0;
+    st->finished = 0;
+}
+
+/* Moves to the next segment, wiping the subkey after the final one. */
+static void stream_advance(chacha20_stream_state_t *st, int final)
+{
+    st->counter++;
+
+    if (final) {
+        wipe(st->key, sizeof(st->key));
+        st->finished = 1;
+    }
+}
+
+int chacha20_stream_init_push(chacha20_stream_state_t *st, const uint8_t key[32],
+                              uint8_t header[CHACHA20_STREAM_HEADER_BYTES])
+{
+    if (chacha20_rng_bytes(header, CHACHA20_STREAM_HEADER_BYTES) != 0) {
+        return 1;
+    }
+
+    stream_init(st, key, header);
+
+    return 0;
+}
+
+int chacha20_stream_push(chacha20_stream_state_t *st, const uint8_t *in,
+                         size_t in_len, uint8_t *out)
+{
+    static const uint8_t constant[4] = {0};
+    uint8_t iv[8];
+
+    if (st->finished || st->counter == UINT64_MAX ||
+        in_len > CHACHA20_STREAM_SEGMENT_BYTES) {
+        return 1;
+    }
+
+    const int final = in_len < CHACHA20_STREAM_SEGMENT_BYTES;
+    const uint8_t flag = final ? STREAM_FLAG_FINAL : STREAM_FLAG_MORE;
+
+    stream_iv(st->counter, iv);
+    chacha20_poly1305_encrypt(st->key, iv, constant, in, in_len, &flag, 1,
+                              out, out + in_len);
+    stream_advance(st, final);
+
+    return 0;
+}
+
+void chacha20_stream_init_pull(chacha20_stream_state_t *st, const uint8_t key[32],
+                               const uint8_t header[CHACHA20_STREAM_HEADER_BYTES])
+{
+    stream_init(st, key, header);
+}
+
+int chacha20_stream_pull(chacha20_stream_state_t *st, const uint8_t *in,
+                         size_t in_len, uint8_t *out, int *final)
+{
+    static const uint8_t constant[4] = {0};
+    uint8_t iv[8];
+
+    if (st->finished || st->counter == UINT64_MAX ||
+        in_len < CHACHA20_STREAM_TAG_BYTES ||
+        in_len > CHACHA20_STREAM_SEGMENT_BYTES + CHACHA20_STREAM_TAG_BYTES) {
+        return 1;
+    }
+
+    const size_t ct_len = in_len - CHACHA20_STREAM_TAG_BYTES;
+    const int is_final = ct_len < CHACHA20_STREAM_SEGMENT_BYTES;
+    const uint8_t flag = is_final ? STREAM_FLAG_FINAL : STREAM_FLAG_MORE;
+
+    stream_iv(st->counter, iv);
+    if (chacha20_poly1305_decrypt(st->key, iv, constant, in, ct_len, &flag, 1,
+                                  in + ct_len, out) != 0) {
+        return -1;
+    }
+
+    stream_advance(st, is_final);
+    *final = is_final;
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+#define _DEFAULT_SOURCE
+
+#include "chacha20_rng.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "chacha20.h"
+
+/* 16 blocks: one pass of the widest keystream kernel. */
+#define RNG_BUF_SIZE 1024
+/* Refills between reseeds from the operating system (64 MiB of output). */
+#define RNG_RESEED_INTERVAL (1u << 16)
+
+struct rng_state {
+    uint8_t key[32];
+    uint8_t buf[RNG_BUF_SIZE];
+    size_t pos;                 /* Next unread byte of buf */
+    unsigned int refills;       /* Refills since the last reseed */
+    unsigned int generation;    /* Fork generation the state was seeded in */
+    int seeded;
+};
+
+static _Thread_local struct rng_state rng;
+
+/* Bumped in the child after fork(), so inherited states reseed. */
+static atomic_uint fork_generation = 1;
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+static void rng_atfork_child(void)
+{
+    atomic_fetch_add_explicit(&fork_generation, 1, memory_order_relaxed);
+}
+
+static void rng_register_atfork(void)
+{
+    pthread_atfork(NULL, NULL, rng_atfork_child);
+}
+
+/* Writes zeros the compiler cannot drop as dead stores. */
+static void wipe(void *p, size_t len)
+{
+    volatile uint8_t *v = p;
+
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+/* Replaces the key with fresh operating system entropy. */
+static int rng_seed(struct rng_state *st)
+{
+    pthread_once(&atfork_once, rng_register_atfork);
+
+    if (getentropy(st->key, sizeof(st->key)) != 0) {
+        return 1;
+    }
+
+    st->pos = RNG_BUF_SIZE;
+    st->refills = 0;
+    st->generation = atomic_load_explicit(&fork_generation, memory_order_relaxed);
+    st->seeded = 1;
+
+    return 0;
+}
+
+/* Generates a buffer of keystream; its first 32 bytes become the next key. */
+static void rng_refill(struct rng_state *st)
+{
+    static const uint8_t nonce[12] = {0};
+    chacha20_ctx_t ctx;
+
+    chacha20_ctx_init(&ctx, st->key, nonce);
+    memset(st->buf, 0, RNG_BUF_SIZE);
+    chacha20_ctx_xor(&ctx, st->buf, RNG_BUF_SIZE, st->buf);
+
+    memcpy(st->key, st->buf, 32);
+    wipe(st->buf, 32);
+    wipe(&ctx, sizeof(ctx));
+
+    st->pos = 32;
+    st->refills++;
+}
+
+/* Makes sure at least one unread byte is buffered. */
+static int rng_ensure(struct rng_state *st)
+{
+    if (!st->seeded || st->refills >= RNG_RESEED_INTERVAL ||
+        st->generation != atomic_load_explicit(&fork_generation, memory_order_relaxed)) {
+        if (rng_seed(st) != 0) {
+            return 1;
+        }
+    }
+
+    if (st->pos == RNG_BUF_SIZE) {
+        rng_refill(st);
+    }
+
+    return 0;
+}
+
+int chacha20_rng_bytes(void *buf, size_t len)
+{
+    uint8_t *out = buf;
+
+    while (len) {
+        if (rng_ensure(&rng) != 0) {
+            return 1;
+        }
+
+        size_t n = RNG_BUF_SIZE - rng.pos;
+        if (n > len) {
+            n = len;
+        }
+
+        memcpy(out, rng.buf + rng.pos, n);
+        wipe(rng.buf + rng.pos, n);
+
+        rng.pos += n;
+        out += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+uint64_t chacha20_rng_u64(void)
+{
+    uint64_t value;
+
+    /* Fast path: enough bytes buffered and no fork since seeding. */
+    if (rng.seeded && RNG_BUF_SIZE - rng.pos >= sizeof(value) &&
+        rng.generation == atomic_load_explicit(&fork_generation, memory_order_relaxed)) {
+        memcpy(&value, rng.buf + rng.pos, sizeof(value));
+        wipe(rng.buf + rng.pos, sizeof(value));
+        rng.pos += sizeof(value);
+        return value;
+    }
+
+    if (chacha20_rng_bytes(&value, sizeof(value)) != 0) {
+        abort();
+    }
+
+    return value;
+}
@@ -0,0 +1,77 @@
+#ifndef __CHACHA20_SIMD__
+#define __CHACHA20_SIMD__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Keystream kernel: XORs ChaCha20 keystream into a buffer.
+ *
+ * Every kernel consumes blocks starting at the counter held in state[12] and
+ * advances it by one per 64-byte block. A trailing partial block uses the
+ * leading bytes of one more keystream block. `data_in` and `data_out` may
+ * alias exactly.
+ *
+ * @param[in]  state       The expanded 16-word ChaCha20 input state.
+ * @param[in]  data_in     Pointer to the data to encrypt/decrypt.
+ * @param[in]  data_length The length of the data in bytes.
+ * @param[out] data_out    Pointer to the result buffer.
+ */
+typedef void (*chacha20_xor_fn)(const uint32_t state[16],
+                                const uint8_t *data_in, size_t data_length,
+                                uint8_t *data_out);
+
+/**
+ * @brief Multi-state kernel: one keystream block from each of N states.
+ *
+ * Lane j runs states[j] as given (key, nonce and counter), so the blocks may
+ * belong to unrelated messages. Block j is written to out + 64 * j.
+ */
+typedef void (*chacha20_blocks_fn)(const uint32_t states[][16], uint8_t *out);
+
+/**
+ * @brief Generates one keystream block per state with the active backend.
+ *
+ * Whole groups go through the widest multi-state kernel available. A
+ * remainder of up to a quarter of its width goes through the row-layout
+ * kernel, anything larger through one padded pass of the wide kernel.
+ *
+ * @param[in]  states The expanded input states; counters are not advanced.
+ * @param[in]  count  Number of states.
+ * @param[out] out    64 * count bytes of keystream.
+ */
+void chacha20_blocks_multi(const uint32_t states[][16], size_t count,
+                           uint8_t *out);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHACHA20_HAVE_X86_KERNELS 1
+
+/** 4 blocks (256 bytes) per iteration in 128-bit lanes. */
+void chacha20_xor_ssse3(const uint32_t state[16], const uint8_t *data_in,
+                        size_t data_length, uint8_t *data_out);
+
+/** 8 blocks (512 bytes) per iteration in 256-bit lanes. */
+void chacha20_xor_avx2(const uint32_t state[16], const uint8_t *data_in,
+                       size_t data_length, uint8_t *data_out);
+
+/** 16 blocks (1024 bytes) per iteration in 512-bit lanes. */
+void chacha20_xor_avx512(const uint32_t state[16], const uint8_t *data_in,
+                         size_t data_length, uint8_t *data_out);
+
+/** Multi-state kernels over 4, 8 and 16 lanes. */
+void chacha20_blocks_ssse3(const uint32_t states[4][16], uint8_t out[4 * 64]);
+void chacha20_blocks_avx2(const uint32_t states[8][16], uint8_t out[8 * 64]);
+void chacha20_blocks_avx512(const uint32_t states[16][16], uint8_t out[16 * 64]);
+
+/**
+ * Row-layout kernels for very few blocks: 1..2 (AVX2) or 1..4 (AVX-512)
+ * states per call, one block per 128-bit lane, at about the latency of a
+ * single block. Writes 64 * count bytes.
+ */
+void chacha20_blocks_rows_avx2(const uint32_t states[][16], size_t count,
+                               uint8_t *out);
+void chacha20_blocks_rows_avx512(const uint32_t states[][16], size_t count,
+                                 uint8_t *out);
+#endif
+
+#endif /* __CHACHA20_SIMD__ */
@@ -0,0 +1,160 @@
+#include "chacha20_simd.h"
+
+#if defined(CHACHA20_HAVE_X86_KERNELS)
+#include <immintrin.h>
+
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+
+#define ROTL_SHIFT(x, n) \
+    _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32 - (n)))
+
+/* 16 and 8 bit rotations are whole-byte moves, done with a single pshufb. */
+#define QUARTER_ROUND(a, b, c, d)                                     \
+    do {                                                              \
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a);             \
+        d = _mm_shuffle_epi8(d, rot16);                               \
+        c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c);             \
+        b = ROTL_SHIFT(b, 12);                                        \
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a);             \
+        d = _mm_shuffle_epi8(d, rot8);                                \
+        c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c);             \
+        b = ROTL_SHIFT(b, 7);                                         \
+    } while (0)
+
+/* out[j] = lane j of in[0..3]: a 4x4 transpose of 32-bit words. */
+SSSE3_TARGET
+static inline void transpose4x4(const __m128i in[4], __m128i out[4])
+{
+    __m128i t0 = _mm_unpacklo_epi32(in[0], in[1]);
+    __m128i t1 = _mm_unpacklo_epi32(in[2], in[3]);
+    __m128i t2 = _mm_unpackhi_epi32(in[0], in[1]);
+    __m128i t3 = _mm_unpackhi_epi32(in[2], in[3]);
+
+    out[0] = _mm_unpacklo_epi64(t0, t1);
+    out[1] = _mm_unpackhi_epi64(t0, t1);
+    out[2] = _mm_unpacklo_epi64(t2, t3);
+    out[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/**
+ * @brief Computes 4 keystream blocks from per-lane input words.
+ *
+ * Register s[i] holds word i of the four input states; the blocks may
+ * belong to unrelated keys, nonces and counters. After the rounds each 4x4
+ * group of words is transposed back, so ks[4 * b + g] holds bytes
+ * 16g..16g+15 of block b.
+ */
+SSSE3_TARGET
+static inline void keystream4_lanes(const __m128i s[16], __m128i ks[16])
+{
+    const __m128i rot16 = _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10,
+                                       5, 4, 7, 6, 1, 0, 3, 2);
+    const __m128i rot8 = _mm_set_epi8(14, 13, 12, 15, 10, 9, 8, 11,
+                                      6, 5, 4, 7, 2, 1, 0, 3);
+    __m128i x[16];
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = s[i];
+    }
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm_add_epi32(x[i], s[i]);
+    }
+
+    for (int g = 0; g < 4; g++) {
+        __m128i t[4];
+
+        transpose4x4(&x[4 * g], t);
+        for (int b = 0; b < 4; b++) {
+            ks[4 * b + g] = t[b];
+        }
+    }
+}
+
+/* Computes 4 consecutive keystream blocks of one state. */
+SSSE3_TARGET
+static inline void keystream4(const uint32_t state[16], __m128i ks[16])
+{
+    __m128i s[16];
+
+    for (int i = 0; i < 16; i++) {
+        s[i] = _mm_set1_epi32((int)state[i]);
+    }
+    s[12] = _mm_add_epi32(s[12], _mm_set_epi32(3, 2, 1, 0));
+
+    keystream4_lanes(s, ks);
+}
+
+SSSE3_TARGET
+void chacha20_xor_ssse3(const uint32_t state[16], const uint8_t *data_in,
+                        size_t data_length, uint8_t *data_out)
+{
+    uint32_t st[16];
+    __m128i ks[16];
+
+    for (int i = 0; i < 16; i++) {
+        st[i] = state[i];
+    }
+
+    while (data_length >= 256) {
+        keystream4(st, ks);
+        for (int k = 0; k < 16; k++) {
+            __m128i d = _mm_loadu_si128((const __m128i *)(data_in + 16 * k));
+            _mm_storeu_si128((__m128i *)(data_out + 16 * k),
+                             _mm_xor_si128(d, ks[k]));
+        }
+        st[12] += 4;
+        data_in += 256;
+        data_out += 256;
+        data_length -= 256;
+    }
+
+    if (data_length) {
+        uint8_t buf[256];
+
+        keystream4(st, ks);
+        for (int k = 0; k < 16; k++) {
+            _mm_storeu_si128((__m128i *)(buf + 16 * k), ks[k]);
+        }
+        for (size_t i = 0; i < data_length; i++) {
+            data_out[i] = data_in[i] ^ buf[i];
+        }
+    }
+}
+
+SSSE3_TARGET
+void chacha20_blocks_ssse3(const uint32_t states[4][16], uint8_t out[4 * 64])
+{
+    __m128i s[16];
+    __m128i ks[16];
+
+    /* Transposing each 4x4 word group of the states gives word-major lanes. */
+    for (int g = 0; g < 4; g++) {
+        __m128i rows[4];
+
+        for (int b = 0; b < 4; b++) {
+            rows[b] = _mm_loadu_si128((const __m128i *)&states[b][4 * g]);
+        }
+        transpose4x4(rows, &s[4 * g]);
+    }
+
+    keystream4_lanes(s, ks);
+
+    /* The transpose leaves the blocks in order, so out is ks stored as is. */
+    for (int k = 0; k < 16; k++) {
+        _mm_storeu_si128((__m128i *)(out + 16 * k), ks[k]);
+    }
+}
+#endif /* CHACHA20_HAVE_X86_KERNELS */
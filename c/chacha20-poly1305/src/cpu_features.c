@@ -0,0 +1,85 @@
+#include "cpu_features.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+/* Reads the XCR0 register, which tells which register files the OS saves. */
+static uint64_t xgetbv0(void)
+{
+    uint32_t eax, edx;
+
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static unsigned int cpu_probe(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int features = 0;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+
+    if (ecx & bit_SSSE3) {
+        features |= CPU_FEATURE_SSSE3;
+    }
+
+    /* YMM registers need both OSXSAVE and the SSE/AVX bits set in XCR0. */
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return features;
+    }
+    uint64_t xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) {
+        return features;
+    }
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return features;
+    }
+
+    if (ebx & bit_AVX2) {
+        features |= CPU_FEATURE_AVX2;
+    }
+
+    /*
+     * ZMM registers also need the opmask and both upper-ZMM bits in XCR0.
+     * Emulators and some hypervisors advertise AVX-512 in CPUID without
+     * enabling that state, so the CPUID bits alone are not enough.
+     */
+    if ((xcr0 & 0xe0) == 0xe0) {
+        if (ebx & bit_AVX512F) {
+            features |= CPU_FEATURE_AVX512F;
+        }
+        if (ebx & bit_AVX512VL) {
+            features |= CPU_FEATURE_AVX512VL;
+        }
+    }
+
+    return features;
+}
+#else
+static unsigned int cpu_probe(void)
+{
+    return 0;
+}
+#endif
+
+/* Bit 31 marks the cache as filled, so a CPU with no features is cached too. */
+#define CPU_FEATURES_PROBED (1u << 31)
+
+unsigned int cpu_features(void)
+{
+    static atomic_uint cached = 0;
+
+    unsigned int features = atomic_load_explicit(&cached, memory_order_relaxed);
+    if (!(features & CPU_FEATURES_PROBED)) {
+        features = cpu_probe() | CPU_FEATURES_PROBED;
+        atomic_store_explicit(&cached, features, memory_order_relaxed);
+    }
+
+    return features & ~CPU_FEATURES_PROBED;
+}
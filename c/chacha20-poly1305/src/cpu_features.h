@@ -0,0 +1,20 @@
+#ifndef __CPU_FEATURES__
+#define __CPU_FEATURES__
+
+#define CPU_FEATURE_SSSE3    (1u << 0) /**< SSSE3 (128-bit byte shuffles) */
+#define CPU_FEATURE_AVX2     (1u << 1) /**< AVX2 with OS-enabled YMM state */
+#define CPU_FEATURE_AVX512F  (1u << 2) /**< AVX-512F with OS-enabled ZMM state */
+#define CPU_FEATURE_AVX512VL (1u << 3) /**< AVX-512VL (EVEX on 128/256-bit) */
+
+/**
+ * @brief Returns the SIMD extensions usable on the running CPU.
+ *
+ * The CPUID probe runs once and its result is cached. An extension is only
+ * reported when the operating system also saves the matching register state
+ * (checked through XGETBV), so the result is safe to dispatch on.
+ *
+ * @return A bitmask of CPU_FEATURE_* flags, 0 on non-x86 targets.
+ */
+unsigned int cpu_features(void);
+
+#endif /* __CPU_FEATURES__ */
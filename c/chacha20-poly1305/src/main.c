@@ -1,9 +1,49 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 #include "chacha20.h"
 #include "poly1305.h"
 #include "chacha20_poly1305.h"
+#include "chacha20_poly1305_keycache.h"
+#include "chacha20_poly1305_nonce.h"
+#include "chacha20_poly1305_precomp.h"
+#include "chacha20_poly1305_stream.h"
+#include "chacha20_rng.h"
+#include "chacha20_simd.h"
+
+/* Key cache loader for the tests: key i of tenant n is n + i; tenant 99 is unknown. */
+static int test_key_loader(void *arg, uint64_t key_id, uint8_t key[32])
+{
+    (void)arg;
+
+    if (key_id == 99) {
+        return 1;
+    }
+    for (size_t i = 0; i < 32; i++) {
+        key[i] = (uint8_t)(key_id + i);
+    }
+
+    return 0;
+}
+
+/* Loader that rotates tenant 7 while its first load is in flight. */
+struct test_rotating_loader {
+    chacha20_keycache_t *cache;
+    unsigned int loads;
+};
+
+static int test_rotating_key_loader(void *arg, uint64_t key_id, uint8_t key[32])
+{
+    struct test_rotating_loader *loader = arg;
+
+    if (loader->loads++ == 0) {
+        chacha20_keycache_invalidate(loader->cache, key_id);
+    }
+
+    return test_key_loader(NULL, key_id, key);
+}
 
 int main()
 {
@@ -63,6 +103,231 @@ int main()
     }
 
 
+    /* ChaCha20 Context Test (RFC 8439 vector split across calls) */
+    passed = true;
+
+    chacha20_ctx_t chacha20_ctx;
+    chacha20_ctx_init(&chacha20_ctx, chacha20_key, chacha20_nonce);
+    chacha20_ctx_set_counter(&chacha20_ctx, chacha20_counter);
+    chacha20_ctx_xor(&chacha20_ctx, chacha20_pt, 64, chacha20_ct);
+    chacha20_ctx_xor(&chacha20_ctx, chacha20_pt + 64, 114 - 64, chacha20_ct + 64);
+
+    for (size_t i = 0; i < 114; i++) {
+        if (chacha20_ct[i] != chacha20_expected_ct[i]) {
+            passed = false;
+        }
+    }
+
+    printf("ChaCha20 Context Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha20 Streaming Test (RFC 8439 vector in uneven chunks) */
+    passed = true;
+
+    static const size_t chacha20_chunks[] = { 1, 7, 60, 3, 43 };
+    size_t chacha20_stream_off = 0;
+
+    chacha20_ctx_init(&chacha20_ctx, chacha20_key, chacha20_nonce);
+    chacha20_ctx_set_counter(&chacha20_ctx, chacha20_counter);
+    for (size_t i = 0; i < sizeof(chacha20_chunks) / sizeof(chacha20_chunks[0]); i++) {
+        chacha20_stream_update(&chacha20_ctx, chacha20_pt + chacha20_stream_off,
+                               chacha20_chunks[i], chacha20_ct + chacha20_stream_off);
+        chacha20_stream_off += chacha20_chunks[i];
+    }
+
+    for (size_t i = 0; i < 114; i++) {
+        if (chacha20_ct[i] != chacha20_expected_ct[i]) {
+            passed = false;
+        }
+    }
+
+    printf("ChaCha20 Streaming Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha20 Random Access Test (RFC 8439 vector from mid-block offsets) */
+    passed = true;
+
+    for (size_t off = 0; off < 114; off += 13) {
+        uint8_t chacha20_ra_out[114];
+
+        chacha20_apply_at(chacha20_key, chacha20_nonce, chacha20_counter, off,
+                          chacha20_pt + off, 114 - off, chacha20_ra_out);
+
+        for (size_t i = off; i < 114; i++) {
+            if (chacha20_ra_out[i - off] != chacha20_expected_ct[i]) {
+                passed = false;
+            }
+        }
+    }
+
+    if (chacha20_apply_at(chacha20_key, chacha20_nonce, 0xffffffff, 32,
+                          chacha20_pt, 64, chacha20_ct) == 0) {
+        passed = false; /* Crosses the end of the counter space. */
+    }
+    if (chacha20_apply_at(chacha20_key, chacha20_nonce, 0, UINT64_MAX - 10,
+                          chacha20_pt, 5, chacha20_ct) == 0 ||
+        chacha20_apply_at(chacha20_key, chacha20_nonce, 0, UINT64_MAX - 63,
+                          chacha20_pt, 64, chacha20_ct) == 0 ||
+        chacha20_apply_at(chacha20_key, chacha20_nonce, 0, UINT64_MAX,
+                          chacha20_pt, 1, chacha20_ct) == 0) {
+        passed = false; /* Offsets near 2^64 must not wrap back to block 0. */
+    }
+
+    printf("ChaCha20 Random Access Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha20 Multi-Block Test (SIMD kernels vs. single blocks) */
+    passed = true;
+
+    uint8_t chacha20_mb_data[1337];
+    uint8_t chacha20_mb_out[1337];
+    uint8_t chacha20_mb_block[64];
+
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+        chacha20_mb_data[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    chacha20_apply(chacha20_key, chacha20_counter, chacha20_nonce,
+                   chacha20_mb_data, sizeof(chacha20_mb_data), chacha20_mb_out);
+
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+        if (i % 64 == 0) {
+            chacha20_block(chacha20_key, chacha20_counter + (uint32_t)(i / 64),
+                           chacha20_nonce, chacha20_mb_block);
+        }
+        if (chacha20_mb_out[i] != (chacha20_mb_data[i] ^ chacha20_mb_block[i % 64])) {
+            passed = false;
+        }
+    }
+
+    printf("ChaCha20 Multi-Block Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha20 Parallel Test (thread pool vs. single thread) */
+    passed = true;
+
+    uint8_t chacha20_par_out[sizeof(chacha20_mb_data)];
+    chacha20_parallel_opts_t chacha20_par_opts = { .workers = 4, .min_chunk = 64 };
+
+    chacha20_apply_parallel(chacha20_key, chacha20_counter, chacha20_nonce,
+                            chacha20_mb_data, sizeof(chacha20_mb_data),
+                            chacha20_par_out, &chacha20_par_opts);
+
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+        if (chacha20_par_out[i] != chacha20_mb_out[i]) {
+            passed = false;
+        }
+    }
+
+    printf("ChaCha20 Parallel Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha8 / ChaCha12 Test Vectors (draft-strombergson-chacha-test-vectors, TC1) */
+    passed = true;
+
+    uint8_t reduced_key[32] = {0};
+    uint8_t reduced_nonce[12] = {0};
+    uint8_t reduced_keystream[64];
+    uint8_t chacha8_expected[64] = {
+        0x3e, 0x00, 0xef, 0x2f, 0x89, 0x5f, 0x40, 0xd6, 0x7f, 0x5b, 0xb8, 0xe8,
+        0x1f, 0x09, 0xa5, 0xa1, 0x2c, 0x84, 0x0e, 0xc3, 0xce, 0x9a, 0x7f, 0x3b,
+        0x18, 0x1b, 0xe1, 0x88, 0xef, 0x71, 0x1a, 0x1e, 0x98, 0x4c, 0xe1, 0x72,
+        0xb9, 0x21, 0x6f, 0x41, 0x9f, 0x44, 0x53, 0x67, 0x45, 0x6d, 0x56, 0x19,
+        0x31, 0x4a, 0x42, 0xa3, 0xda, 0x86, 0xb0, 0x01, 0x38, 0x7b, 0xfd, 0xb8,
+        0x0e, 0x0c, 0xfe, 0x42
+    };
+    uint8_t chacha12_expected[64] = {
+        0x9b, 0xf4, 0x9a, 0x6a, 0x07, 0x55, 0xf9, 0x53, 0x81, 0x1f, 0xce, 0x12,
+        0x5f, 0x26, 0x83, 0xd5, 0x04, 0x29, 0xc3, 0xbb, 0x49, 0xe0, 0x74, 0x14,
+        0x7e, 0x00, 0x89, 0xa5, 0x2e, 0xae, 0x15, 0x5f, 0x05, 0x64, 0xf8, 0x79,
+        0xd2, 0x7a, 0xe3, 0xc0, 0x2c, 0xe8, 0x28, 0x34, 0xac, 0xfa, 0x8c, 0x79,
+        0x3a, 0x62, 0x9f, 0x2c, 0xa0, 0xde, 0x69, 0x19, 0x61, 0x0b, 0xe8, 0x2f,
+        0x41, 0x13, 0x26, 0xbe
+    };
+
+    chacha8_block(reduced_key, 0, reduced_nonce, reduced_keystream);
+    for (size_t i = 0; i < 64; i++) {
+        if (reduced_keystream[i] != chacha8_expected[i]) {
+            passed = false;
+        }
+    }
+
+    chacha12_block(reduced_key, 0, reduced_nonce, reduced_keystream);
+    for (size_t i = 0; i < 64; i++) {
+        if (reduced_keystream[i] != chacha12_expected[i]) {
+            passed = false;
+        }
+    }
+
+    printf("ChaCha8 / ChaCha12 Test Vectors -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha8 / ChaCha12 Apply Test (multi-block apply with a tail vs. single blocks) */
+    passed = true;
+
+    for (int variant = 0; variant < 2; variant++) {
+        int (*reduced_apply)(const uint8_t [32], uint32_t, const uint8_t [12],
+                             const uint8_t *, size_t, uint8_t *) =
+            variant == 0 ? chacha8_apply : chacha12_apply;
+        int (*reduced_block)(const uint8_t [32], uint32_t, const uint8_t [12],
+                             uint8_t [64]) =
+            variant == 0 ? chacha8_block : chacha12_block;
+        uint8_t reduced_out[sizeof(chacha20_mb_data)];
+
+        if (reduced_apply(chacha20_key, chacha20_counter, chacha20_nonce, chacha20_mb_data,
+                          sizeof(chacha20_mb_data), reduced_out) != 0) {
+            passed = false;
+        }
+
+        for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+            if (i % 64 == 0) {
+                reduced_block(chacha20_key, chacha20_counter + (uint32_t)(i / 64),
+                              chacha20_nonce, reduced_keystream);
+            }
+            if (reduced_out[i] != (chacha20_mb_data[i] ^ reduced_keystream[i % 64])) {
+                passed = false;
+            }
+        }
+    }
+
+    printf("ChaCha8 / ChaCha12 Apply Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
     /* Poly1305 Test Vector */
     passed = true;
 
@@ -98,6 +363,277 @@ int main()
     }
 
 
+    /* Poly1305 Incremental Test (RFC 8439 vector in uneven pieces) */
+    passed = true;
+
+    poly1305_state_t poly1305_st;
+    poly1305_init(&poly1305_st, poly1305_key);
+    poly1305_update(&poly1305_st, poly1305_input, 5);
+    poly1305_update(&poly1305_st, poly1305_input + 5, 0);
+    poly1305_update(&poly1305_st, poly1305_input + 5, 20);
+    poly1305_update(&poly1305_st, poly1305_input + 25, 9);
+    poly1305_final(&poly1305_st, poly1305_tag);
+
+    for (size_t i = 0; i < 16; i++) {
+        if (poly1305_tag[i] != poly1305_expected_tag[i]) {
+            passed = false;
+        }
+    }
+
+    printf("Poly1305 Incremental Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* Poly1305 SIMD Test (long one-shot message vs. short scalar updates) */
+    passed = true;
+
+    uint8_t poly1305_bulk_tag[16];
+    poly1305_mac(poly1305_key, chacha20_mb_data, sizeof(chacha20_mb_data), poly1305_bulk_tag);
+
+    poly1305_init(&poly1305_st, poly1305_key);
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i += 13) {
+        size_t n = sizeof(chacha20_mb_data) - i < 13 ? sizeof(chacha20_mb_data) - i : 13;
+        poly1305_update(&poly1305_st, chacha20_mb_data + i, n);
+    }
+    poly1305_final(&poly1305_st, poly1305_tag);
+
+    for (size_t i = 0; i < 16; i++) {
+        if (poly1305_tag[i] != poly1305_bulk_tag[i]) {
+            passed = false;
+        }
+    }
+
+    printf("Poly1305 SIMD Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* Poly1305 Edge Case Vectors (RFC 8439 A.3: accumulators near 2^130 - 5) */
+    passed = true;
+
+    static const uint8_t poly1305_ietf_text[] =
+        "Any submission to the IETF intended by the Contributor for "
+        "publication as all or part of an IETF Internet-Draft or RFC "
+        "and any statement made within the context of an IETF activity "
+        "is considered an \"IETF Contribution\". Such statements include "
+        "oral statements in IETF sessions, as well as written and "
+        "electronic communications made at any time or place, which "
+        "are addressed to";
+    static const uint8_t poly1305_a3_zeros[64] = { 0 };
+    static const uint8_t poly1305_jabberwocky[] =
+        "'Twas brillig, and the slithy toves\n"
+        "Did gyre and gimble in the wabe:\n"
+        "All mimsy were the borogoves,\n"
+        "And the mome raths outgrabe.";
+    static const uint8_t poly1305_a3_5[16] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff
+    };
+    static const uint8_t poly1305_a3_6[16] = {
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00
+    };
+    static const uint8_t poly1305_a3_7[48] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xf0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x11, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+    static const uint8_t poly1305_a3_8[48] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xfb, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe,
+        0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0x01, 0x01, 0x01, 0x01,
+        0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01
+    };
+    static const uint8_t poly1305_a3_9[16] = {
+        0xfd, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff
+    };
+    static const uint8_t poly1305_a3_10[64] = {
+        0xe3, 0x35, 0x94, 0xd7, 0x50, 0x5e, 0x43, 0xb9, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x33, 0x94, 0xd7, 0x50, 0x5e, 0x43, 0x79, 0xcd,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00
+    };
+    static const struct {
+        uint8_t key[32];
+        const uint8_t *msg;
+        size_t len;
+        uint8_t tag[16];
+    } poly1305_a3[11] = {
+        { /* #1 */
+            {
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_zeros, 64,
+            {
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        },
+        { /* #2 */
+            {
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x36, 0xe5, 0xf6, 0xb5, 0xc5, 0xe0, 0x60, 0x70,
+                0xf0, 0xef, 0xca, 0x96, 0x22, 0x7a, 0x86, 0x3e
+            },
+            poly1305_ietf_text, 375,
+            {
+                0x36, 0xe5, 0xf6, 0xb5, 0xc5, 0xe0, 0x60, 0x70, 0xf0, 0xef, 0xca, 0x96,
+                0x22, 0x7a, 0x86, 0x3e
+            }
+        },
+        { /* #3 */
+            {
+                0x36, 0xe5, 0xf6, 0xb5, 0xc5, 0xe0, 0x60, 0x70, 0xf0, 0xef, 0xca, 0x96,
+                0x22, 0x7a, 0x86, 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_ietf_text, 375,
+            {
+                0xf3, 0x47, 0x7e, 0x7c, 0xd9, 0x54, 0x17, 0xaf, 0x89, 0xa6, 0xb8, 0x79,
+                0x4c, 0x31, 0x0c, 0xf0
+            }
+        },
+        { /* #4 */
+            {
+                0x1c, 0x92, 0x40, 0xa5, 0xeb, 0x55, 0xd3, 0x8a, 0xf3, 0x33, 0x88, 0x86,
+                0x04, 0xf6, 0xb5, 0xf0, 0x47, 0x39, 0x17, 0xc1, 0x40, 0x2b, 0x80, 0x09,
+                0x9d, 0xca, 0x5c, 0xbc, 0x20, 0x70, 0x75, 0xc0
+            },
+            poly1305_jabberwocky, 127,
+            {
+                0x45, 0x41, 0x66, 0x9a, 0x7e, 0xaa, 0xee, 0x61, 0xe7, 0x08, 0xdc, 0x7c,
+                0xbc, 0xc5, 0xeb, 0x62
+            }
+        },
+        { /* #5 */
+            {
+                0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_5, 16,
+            {
+                0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        },
+        { /* #6 */
+            {
+                0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+            },
+            poly1305_a3_6, 16,
+            {
+                0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        },
+        { /* #7 */
+            {
+                0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_7, 48,
+            {
+                0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        },
+        { /* #8 */
+            {
+                0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_8, 48,
+            {
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        },
+        { /* #9 */
+            {
+                0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_9, 16,
+            {
+                0xfa, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                0xff, 0xff, 0xff, 0xff
+            }
+        },
+        { /* #10 */
+            {
+                0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_10, 64,
+            {
+                0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x55, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        },
+        { /* #11 */
+            {
+                0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            },
+            poly1305_a3_10, 48,
+            {
+                0x13, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            }
+        }
+    };
+
+    for (size_t v = 0; v < 11; v++) {
+        poly1305_mac(poly1305_a3[v].key, poly1305_a3[v].msg, poly1305_a3[v].len, poly1305_tag);
+        for (size_t i = 0; i < 16; i++) {
+            if (poly1305_tag[i] != poly1305_a3[v].tag[i]) {
+                passed = false;
+            }
+        }
+
+        /* Block by block, so long vectors also go through the scalar limbs. */
+        poly1305_init(&poly1305_st, poly1305_a3[v].key);
+        for (size_t i = 0; i < poly1305_a3[v].len; i += 16) {
+            size_t n = poly1305_a3[v].len - i < 16 ? poly1305_a3[v].len - i : 16;
+            poly1305_update(&poly1305_st, poly1305_a3[v].msg + i, n);
+        }
+        poly1305_final(&poly1305_st, poly1305_tag);
+        for (size_t i = 0; i < 16; i++) {
+            if (poly1305_tag[i] != poly1305_a3[v].tag[i]) {
+                passed = false;
+            }
+        }
+    }
+
+    printf("Poly1305 Edge Case Vectors -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
     /* Poly1305 Key Generation Test Vector */
     passed = true;
 
@@ -202,5 +738,788 @@ int main()
         printf("Failed\n");
     }
 
+
+    /* AEAD Scatter/Gather Test (RFC 8439 vector split into uneven fragments) */
+    passed = true;
+
+    uint8_t aead_pt_out[114];
+    uint8_t aead_ct_out[114];
+    struct iovec aead_aad_iov[2] = {
+        { aead_aad, 5 }, { aead_aad + 5, 7 }
+    };
+    struct iovec aead_pt_iov[3] = {
+        { aead_pt, 7 }, { aead_pt + 7, 0 }, { aead_pt + 7, 107 }
+    };
+    struct iovec aead_ct_iov[2] = {
+        { aead_ct_out, 70 }, { aead_ct_out + 70, 44 }
+    };
+    struct iovec aead_out_iov[3] = {
+        { aead_pt_out, 1 }, { aead_pt_out + 1, 64 }, { aead_pt_out + 65, 49 }
+    };
+
+    if (chacha20_poly1305_encryptv(aead_key, aead_iv, aead_constant, aead_aad_iov, 2,
+                                   aead_pt_iov, 3, aead_ct_iov, 2, aead_tag) != 0) {
+        passed = false;
+    }
+
+    for (size_t i = 0; i < 114; i++) {
+        if (aead_ct_out[i] != aead_expected_ct[i]) {
+            passed = false;
+        }
+    }
+
+    for (size_t i = 0; i < 16; i++) {
+        if (aead_tag[i] != aead_expected_tag[i]) {
+            passed = false;
+        }
+    }
+
+    if (chacha20_poly1305_decryptv(aead_key, aead_iv, aead_constant, aead_aad_iov, 2,
+                                   aead_ct_iov, 2, aead_tag, aead_out_iov, 3) != 0) {
+        passed = false;
+    }
+
+    for (size_t i = 0; i < 114; i++) {
+        if (aead_pt_out[i] != aead_pt[i]) {
+            passed = false;
+        }
+    }
+
+    aead_tag[0] ^= 1;
+    if (chacha20_poly1305_decryptv(aead_key, aead_iv, aead_constant, aead_aad_iov, 2,
+                                   aead_ct_iov, 2, aead_tag, aead_out_iov, 3) != -1) {
+        passed = false;
+    }
+
+    for (size_t i = 0; i < 114; i++) {
+        if (aead_pt_out[i] != 0) {
+            passed = false;
+        }
+    }
+
+    printf("AEAD Scatter/Gather Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD Session Test (record n sealed under IV n, no IV wrap) */
+    passed = true;
+
+    chacha20_poly1305_session_t sealer;
+    chacha20_poly1305_session_t opener;
+    chacha20_poly1305_session_init(&sealer, aead_key, aead_constant);
+    chacha20_poly1305_session_init(&opener, aead_key, aead_constant);
+
+    for (uint64_t n = 0; n < 3; n++) {
+        uint8_t record_iv[8];
+        uint8_t expected_ct[114];
+        uint8_t expected_tag[16];
+
+        for (size_t i = 0; i < 8; i++) {
+            record_iv[i] = (uint8_t)(n >> (8 * i));
+        }
+        chacha20_poly1305_encrypt(aead_key, record_iv, aead_constant, aead_pt, 114,
+                                  aead_aad, 12, expected_ct, expected_tag);
+
+        if (chacha20_poly1305_seal(&sealer, aead_pt, 114, aead_aad, 12,
+                                   aead_ct, aead_tag) != 0) {
+            passed = false;
+        }
+        for (size_t i = 0; i < 114; i++) {
+            if (aead_ct[i] != expected_ct[i]) {
+                passed = false;
+            }
+        }
+        for (size_t i = 0; i < 16; i++) {
+            if (aead_tag[i] != expected_tag[i]) {
+                passed = false;
+            }
+        }
+
+        /* A forged record is rejected without consuming the IV. */
+        aead_tag[15] ^= 0x80;
+        if (chacha20_poly1305_open(&opener, aead_ct, 114, aead_aad, 12,
+                                   aead_tag, aead_pt_out) != -1) {
+            passed = false;
+        }
+        aead_tag[15] ^= 0x80;
+        if (chacha20_poly1305_open(&opener, aead_ct, 114, aead_aad, 12,
+                                   aead_tag, aead_pt_out) != 0) {
+            passed = false;
+        }
+        for (size_t i = 0; i < 114; i++) {
+            if (aead_pt_out[i] != aead_pt[i]) {
+                passed = false;
+            }
+        }
+    }
+
+    sealer.seq = UINT64_MAX;
+    if (chacha20_poly1305_seal(&sealer, aead_pt, 114, aead_aad, 12, aead_ct, aead_tag) != 0 ||
+        chacha20_poly1305_seal(&sealer, aead_pt, 114, aead_aad, 12, aead_ct, aead_tag) != 1) {
+        passed = false;
+    }
+    chacha20_poly1305_session_wipe(&sealer);
+    chacha20_poly1305_session_wipe(&opener);
+
+    printf("AEAD Session Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD Precompute Test (ring-sealed records match record n under IV n) */
+    passed = true;
+
+    chacha20_poly1305_session_t precomp_session;
+    chacha20_poly1305_session_init(&precomp_session, aead_key, aead_constant);
+    chacha20_poly1305_precomp_t *precomp =
+        chacha20_poly1305_precomp_start(&precomp_session, 4, 64);
+    chacha20_poly1305_precomp_stats_t precomp_stats;
+
+    if (precomp == NULL) {
+        passed = false;
+    }
+
+    /* Let the helper fill the ring (giving up after about five seconds). */
+    for (int i = 0; precomp != NULL && i < 5000 &&
+                    chacha20_poly1305_precomp_ready(precomp) < 4; i++) {
+        nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+    }
+    if (precomp != NULL && chacha20_poly1305_precomp_ready(precomp) != 4) {
+        passed = false;
+    }
+
+    for (uint64_t n = 0; precomp != NULL && n < 12; n++) {
+        /* Records over 64 bytes are sealed inline; record 5 bypasses the ring. */
+        size_t len = (n % 3 == 0) ? 114 : (size_t)(n * 5);
+        uint8_t record_iv[8];
+        uint8_t expected_ct[114];
+        uint8_t expected_tag[16];
+
+        for (size_t i = 0; i < 8; i++) {
+            record_iv[i] = (uint8_t)(n >> (8 * i));
+        }
+        chacha20_poly1305_encrypt(aead_key, record_iv, aead_constant, aead_pt, len,
+                                  aead_aad, 12, expected_ct, expected_tag);
+
+        int ret = (n == 5)
+            ? chacha20_poly1305_seal(&precomp_session, aead_pt, len, aead_aad, 12,
+                                     aead_ct, aead_tag)
+            : chacha20_poly1305_precomp_seal(precomp, &precomp_session, aead_pt, len,
+                                             aead_aad, 12, aead_ct, aead_tag);
+        if (ret != 0) {
+            passed = false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            if (aead_ct[i] != expected_ct[i]) {
+                passed = false;
+            }
+        }
+        for (size_t i = 0; i < 16; i++) {
+            if (aead_tag[i] != expected_tag[i]) {
+                passed = false;
+            }
+        }
+    }
+
+    if (precomp != NULL) {
+        chacha20_poly1305_precomp_stats(precomp, &precomp_stats);
+        /*
+         * With the ring full, record 1 is sealed from it after the slot of
+         * record 0 (sealed inline, too long) is discarded.
+         */
+        if (precomp_stats.precomputed + precomp_stats.inline_seals != 11 ||
+            precomp_stats.precomputed == 0 || precomp_stats.discarded == 0) {
+            passed = false;
+        }
+        chacha20_poly1305_precomp_stop(precomp);
+    }
+    chacha20_poly1305_session_wipe(&precomp_session);
+
+    printf("AEAD Precompute Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD Parallel Test (split Poly1305 matches the serial tag) */
+    passed = true;
+
+    chacha20_parallel_opts_t aead_par_opts = { 4, 64 };
+    uint8_t aead_par_ct[sizeof(chacha20_mb_data)];
+    uint8_t aead_par_pt[sizeof(chacha20_mb_data)];
+    uint8_t aead_ser_ct[sizeof(chacha20_mb_data)];
+    uint8_t aead_ser_tag[16];
+
+    chacha20_poly1305_encrypt(aead_key, aead_iv, aead_constant, chacha20_mb_data,
+                              sizeof(chacha20_mb_data), aead_aad, 12, aead_ser_ct,
+                              aead_ser_tag);
+    chacha20_poly1305_encrypt_parallel(aead_key, aead_iv, aead_constant, chacha20_mb_data,
+                                       sizeof(chacha20_mb_data), aead_aad, 12, aead_par_ct,
+                                       aead_tag, &aead_par_opts);
+
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+        if (aead_par_ct[i] != aead_ser_ct[i]) {
+            passed = false;
+        }
+    }
+    for (size_t i = 0; i < 16; i++) {
+        if (aead_tag[i] != aead_ser_tag[i]) {
+            passed = false;
+        }
+    }
+
+    if (chacha20_poly1305_decrypt_parallel(aead_key, aead_iv, aead_constant, aead_par_ct,
+                                           sizeof(chacha20_mb_data), aead_aad, 12, aead_tag,
+                                           aead_par_pt, &aead_par_opts) != 0) {
+        passed = false;
+    }
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+        if (aead_par_pt[i] != chacha20_mb_data[i]) {
+            passed = false;
+        }
+    }
+
+    /* A tampered tag is rejected and the plaintext buffer zeroed. */
+    aead_tag[15] ^= 0x01;
+    if (chacha20_poly1305_decrypt_parallel(aead_key, aead_iv, aead_constant, aead_par_ct,
+                                           sizeof(chacha20_mb_data), aead_aad, 12, aead_tag,
+                                           aead_par_pt, &aead_par_opts) != -1) {
+        passed = false;
+    }
+    for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+        if (aead_par_pt[i] != 0) {
+            passed = false;
+        }
+    }
+    aead_tag[15] ^= 0x01;
+
+    printf("AEAD Parallel Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD Nonce Allocator Test (disjoint pooled ranges, worker exhaustion) */
+    passed = true;
+
+    static const uint8_t nonce_pool_constant[4] = { 0xff, 0xff, 0xff, 0xff };
+    chacha20_nonce_pool_t nonce_pool;
+    chacha20_nonce_t nonce_a;
+    chacha20_nonce_t nonce_b;
+    uint8_t nonce_constant[4];
+    uint8_t nonce_iv[8];
+
+    /* Two allocators on one pool with 3-IV ranges, each taking a range as needed. */
+    chacha20_nonce_pool_init(&nonce_pool, nonce_pool_constant, 3);
+    chacha20_nonce_init_pooled(&nonce_a, &nonce_pool);
+    chacha20_nonce_init_pooled(&nonce_b, &nonce_pool);
+
+    chacha20_nonce_t *nonce_order[8] = {
+        &nonce_a, &nonce_a, &nonce_a, &nonce_b, &nonce_a, &nonce_b, &nonce_b, &nonce_b
+    };
+    static const uint8_t nonce_expected_ivs[8] = { 0, 1, 2, 3, 6, 4, 5, 9 };
+    for (size_t i = 0; i < 8; i++) {
+        if (chacha20_nonce_next(nonce_order[i], nonce_constant, nonce_iv) != 0 ||
+            nonce_iv[0] != nonce_expected_ivs[i]) {
+            passed = false;
+        }
+        for (size_t j = 0; j < 4; j++) {
+            if (nonce_constant[j] != nonce_pool_constant[j]) {
+                passed = false;
+            }
+        }
+    }
+
+    /* A worker uses its ID as the constant and the full IV range. */
+    chacha20_nonce_init_worker(&nonce_a, 0x01020304);
+    if (chacha20_nonce_encrypt(&nonce_a, aead_key, nonce_constant, nonce_iv,
+                               aead_pt, 114, aead_aad, 12, aead_ct, aead_tag) != 0 ||
+        nonce_constant[0] != 0x04 || nonce_constant[3] != 0x01 ||
+        chacha20_poly1305_decrypt(aead_key, nonce_iv, nonce_constant, aead_ct, 114,
+                                  aead_aad, 12, aead_tag, aead_pt_out) != 0) {
+        passed = false;
+    }
+    for (size_t i = 0; i < 114; i++) {
+        if (aead_pt_out[i] != aead_pt[i]) {
+            passed = false;
+        }
+    }
+    nonce_a.next = UINT64_MAX;
+    if (chacha20_nonce_next(&nonce_a, nonce_constant, nonce_iv) != 0 ||
+        nonce_iv[7] != 0xff ||
+        chacha20_nonce_next(&nonce_a, nonce_constant, nonce_iv) != 1) {
+        passed = false;
+    }
+
+    /* The pool's last range ends exactly on the last IV, then the pool is exhausted. */
+    atomic_store(&nonce_pool.next, UINT64_MAX - 2);
+    chacha20_nonce_init_pooled(&nonce_b, &nonce_pool);
+    for (size_t i = 0; i < 3; i++) {
+        if (chacha20_nonce_next(&nonce_b, nonce_constant, nonce_iv) != 0 ||
+            nonce_iv[0] != (uint8_t)(0xfd + i) || nonce_iv[7] != 0xff) {
+            passed = false;
+        }
+    }
+    chacha20_nonce_init_pooled(&nonce_a, &nonce_pool);
+    if (chacha20_nonce_next(&nonce_b, nonce_constant, nonce_iv) != 1 ||
+        chacha20_nonce_next(&nonce_a, nonce_constant, nonce_iv) != 1) {
+        passed = false;
+    }
+
+    /* A range that would run past the last IV is cut short at it. */
+    atomic_store(&nonce_pool.next, UINT64_MAX - 1);
+    chacha20_nonce_init_pooled(&nonce_b, &nonce_pool);
+    if (chacha20_nonce_next(&nonce_b, nonce_constant, nonce_iv) != 0 ||
+        chacha20_nonce_next(&nonce_b, nonce_constant, nonce_iv) != 0 ||
+        nonce_iv[0] != 0xff || nonce_iv[7] != 0xff ||
+        chacha20_nonce_next(&nonce_b, nonce_constant, nonce_iv) != 1) {
+        passed = false;
+    }
+
+    printf("AEAD Nonce Allocator Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD Key Cache Test (cached keys match raw keys, CLOCK eviction, counters) */
+    passed = true;
+
+    chacha20_keycache_t *keycache = chacha20_keycache_create(4, 1, test_key_loader, NULL);
+    chacha20_keycache_stats_t keycache_stats;
+
+    if (keycache == NULL) {
+        passed = false;
+    }
+
+    /* Tenants 0..3 fill the cache, 0 again hits, 4 evicts one entry. */
+    static const uint64_t keycache_tenants[6] = { 0, 1, 2, 3, 0, 4 };
+    for (size_t n = 0; keycache != NULL && n < 6; n++) {
+        uint64_t tenant = keycache_tenants[n];
+        uint8_t tenant_key[32];
+        uint8_t expected_ct[114];
+        uint8_t expected_tag[16];
+
+        test_key_loader(NULL, tenant, tenant_key);
+        chacha20_poly1305_encrypt(tenant_key, aead_iv, aead_constant, aead_pt, 114,
+                                  aead_aad, 12, expected_ct, expected_tag);
+
+        if (chacha20_keycache_encrypt(keycache, tenant, aead_iv, aead_constant,
+                                      aead_pt, 114, aead_aad, 12, aead_ct,
+                                      aead_tag) != 0) {
+            passed = false;
+        }
+        for (size_t i = 0; i < 114; i++) {
+            if (aead_ct[i] != expected_ct[i]) {
+                passed = false;
+            }
+        }
+        for (size_t i = 0; i < 16; i++) {
+            if (aead_tag[i] != expected_tag[i]) {
+                passed = false;
+            }
+        }
+    }
+
+    if (keycache != NULL) {
+        if (chacha20_keycache_decrypt(keycache, 4, aead_iv, aead_constant, aead_ct, 114,
+                                      aead_aad, 12, aead_tag, aead_pt_out) != 0) {
+            passed = false;
+        }
+        for (size_t i = 0; i < 114; i++) {
+            if (aead_pt_out[i] != aead_pt[i]) {
+                passed = false;
+            }
+        }
+
+        chacha20_keycache_stats(keycache, &keycache_stats);
+        if (keycache_stats.hits != 2 || keycache_stats.misses != 5 ||
+            keycache_stats.evictions != 1 || keycache_stats.entries != 4 ||
+            keycache_stats.capacity != 4) {
+            passed = false;
+        }
+
+        chacha20_keycache_invalidate(keycache, 4);
+        chacha20_keycache_stats(keycache, &keycache_stats);
+        if (keycache_stats.entries != 3 ||
+            chacha20_keycache_encrypt(keycache, 99, aead_iv, aead_constant, aead_pt,
+                                      114, aead_aad, 12, aead_ct, aead_tag) != 1) {
+            passed = false;
+        }
+
+        chacha20_keycache_destroy(keycache);
+    }
+
+    /* A key invalidated while it loads is used once but not cached. */
+    struct test_rotating_loader rotating_loader = { NULL, 0 };
+    chacha20_ctx_t rotating_ctx;
+
+    keycache = chacha20_keycache_create(4, 1, test_rotating_key_loader, &rotating_loader);
+    if (keycache == NULL) {
+        passed = false;
+    } else {
+        rotating_loader.cache = keycache;
+
+        if (chacha20_keycache_get(keycache, 7, &rotating_ctx) != 0 ||
+            rotating_loader.loads != 1) {
+            passed = false;
+        }
+        chacha20_keycache_stats(keycache, &keycache_stats);
+        if (keycache_stats.entries != 0) {
+            passed = false;
+        }
+
+        if (chacha20_keycache_get(keycache, 7, &rotating_ctx) != 0 ||
+            chacha20_keycache_get(keycache, 7, &rotating_ctx) != 0 ||
+            rotating_loader.loads != 2) {
+            passed = false;
+        }
+        chacha20_keycache_stats(keycache, &keycache_stats);
+        if (keycache_stats.hits != 1 || keycache_stats.misses != 2 ||
+            keycache_stats.entries != 1) {
+            passed = false;
+        }
+
+        chacha20_keycache_destroy(keycache);
+    }
+
+    printf("AEAD Key Cache Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* HChaCha20 Test Vector (draft-irtf-cfrg-xchacha, section 2.2.1) */
+    passed = true;
+
+    uint8_t hchacha20_nonce[16] = {
+        0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00,
+        0x31, 0x41, 0x59, 0x27
+    };
+    uint8_t hchacha20_subkey[32];
+    uint8_t hchacha20_expected_subkey[32] = {
+        0x82, 0x41, 0x3b, 0x42, 0x27, 0xb2, 0x7b, 0xfe, 0xd3, 0x0e, 0x42, 0x50,
+        0x8a, 0x87, 0x7d, 0x73, 0xa0, 0xf9, 0xe4, 0xd5, 0x8a, 0x74, 0xa8, 0x53,
+        0xc1, 0x2e, 0xc4, 0x13, 0x26, 0xd3, 0xec, 0xdc
+    };
+
+    hchacha20(chacha20_key, hchacha20_nonce, hchacha20_subkey);
+
+    for (size_t i = 0; i < 32; i++) {
+        if (hchacha20_subkey[i] != hchacha20_expected_subkey[i]) {
+            passed = false;
+        }
+    }
+
+    printf("HChaCha20 Test Vector -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD_XCHACHA20_POLY1305 Test Vector (draft-irtf-cfrg-xchacha, A.3.1) */
+    passed = true;
+
+    uint8_t xaead_nonce[24] = {
+        0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b,
+        0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57
+    };
+    uint8_t xaead_ct[114];
+    uint8_t xaead_pt[114];
+    uint8_t xaead_tag[16];
+    uint8_t xaead_expected_ct[114] = {
+        0xbd, 0x6d, 0x17, 0x9d, 0x3e, 0x83, 0xd4, 0x3b, 0x95, 0x76, 0x57, 0x94,
+        0x93, 0xc0, 0xe9, 0x39, 0x57, 0x2a, 0x17, 0x00, 0x25, 0x2b, 0xfa, 0xcc,
+        0xbe, 0xd2, 0x90, 0x2c, 0x21, 0x39, 0x6c, 0xbb, 0x73, 0x1c, 0x7f, 0x1b,
+        0x0b, 0x4a, 0xa6, 0x44, 0x0b, 0xf3, 0xa8, 0x2f, 0x4e, 0xda, 0x7e, 0x39,
+        0xae, 0x64, 0xc6, 0x70, 0x8c, 0x54, 0xc2, 0x16, 0xcb, 0x96, 0xb7, 0x2e,
+        0x12, 0x13, 0xb4, 0x52, 0x2f, 0x8c, 0x9b, 0xa4, 0x0d, 0xb5, 0xd9, 0x45,
+        0xb1, 0x1b, 0x69, 0xb9, 0x82, 0xc1, 0xbb, 0x9e, 0x3f, 0x3f, 0xac, 0x2b,
+        0xc3, 0x69, 0x48, 0x8f, 0x76, 0xb2, 0x38, 0x35, 0x65, 0xd3, 0xff, 0xf9,
+        0x21, 0xf9, 0x66, 0x4c, 0x97, 0x63, 0x7d, 0xa9, 0x76, 0x88, 0x12, 0xf6,
+        0x15, 0xc6, 0x8b, 0x13, 0xb5, 0x2e
+    };
+    uint8_t xaead_expected_tag[16] = {
+        0xc0, 0x87, 0x59, 0x24, 0xc1, 0xc7, 0x98, 0x79, 0x47, 0xde, 0xaf, 0xd8,
+        0x78, 0x0a, 0xcf, 0x49
+    };
+
+    xchacha20_poly1305_encrypt(aead_key, xaead_nonce, aead_pt, 114, aead_aad, 12,
+                               xaead_ct, xaead_tag);
+
+    for (size_t i = 0; i < 114; i++) {
+        if (xaead_ct[i] != xaead_expected_ct[i]) {
+            passed = false;
+        }
+    }
+
+    for (size_t i = 0; i < 16; i++) {
+        if (xaead_tag[i] != xaead_expected_tag[i]) {
+            passed = false;
+        }
+    }
+
+    if (xchacha20_poly1305_decrypt(aead_key, xaead_nonce, xaead_ct, 114, aead_aad, 12,
+                                   xaead_tag, xaead_pt) != 0) {
+        passed = false;
+    }
+
+    for (size_t i = 0; i < 114; i++) {
+        if (xaead_pt[i] != aead_pt[i]) {
+            passed = false;
+        }
+    }
+
+    printf("AEAD_XCHACHA20_POLY1305 Test Vector -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* AEAD Stream Test (two full segments and a short final one) */
+    passed = true;
+
+    enum {
+        STREAM_SEG = CHACHA20_STREAM_SEGMENT_BYTES,
+        STREAM_WIRE = CHACHA20_STREAM_SEGMENT_BYTES + CHACHA20_STREAM_TAG_BYTES
+    };
+    static uint8_t stream_pt[2 * STREAM_SEG + 100];
+    static uint8_t stream_ct[3 * STREAM_WIRE];
+    static uint8_t stream_out[2 * STREAM_SEG + 100];
+    uint8_t stream_header[CHACHA20_STREAM_HEADER_BYTES];
+    chacha20_stream_state_t stream_st;
+    int stream_final = 0;
+
+    for (size_t i = 0; i < sizeof(stream_pt); i++) {
+        stream_pt[i] = (uint8_t)(i * 13 + 1);
+    }
+
+    if (chacha20_stream_init_push(&stream_st, aead_key, stream_header) != 0 ||
+        chacha20_stream_push(&stream_st, stream_pt, STREAM_SEG, stream_ct) != 0 ||
+        chacha20_stream_push(&stream_st, stream_pt + STREAM_SEG, STREAM_SEG,
+                             stream_ct + STREAM_WIRE) != 0 ||
+        chacha20_stream_push(&stream_st, stream_pt + 2 * STREAM_SEG, 100,
+                             stream_ct + 2 * STREAM_WIRE) != 0 ||
+        chacha20_stream_push(&stream_st, stream_pt, 0, stream_ct) != 1) {
+        passed = false;
+    }
+
+    /* Swapped segments must not authenticate. */
+    chacha20_stream_init_pull(&stream_st, aead_key, stream_header);
+    if (chacha20_stream_pull(&stream_st, stream_ct + STREAM_WIRE, STREAM_WIRE,
+                             stream_out, &stream_final) != -1) {
+        passed = false;
+    }
+
+    chacha20_stream_init_pull(&stream_st, aead_key, stream_header);
+    for (size_t k = 0; k < 3; k++) {
+        size_t wire_len = k < 2 ? STREAM_WIRE : 100 + CHACHA20_STREAM_TAG_BYTES;
+        if (chacha20_stream_pull(&stream_st, stream_ct + k * STREAM_WIRE, wire_len,
+                                 stream_out + k * STREAM_SEG, &stream_final) != 0 ||
+            stream_final != (k == 2)) {
+            passed = false;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(stream_pt); i++) {
+        if (stream_out[i] != stream_pt[i]) {
+            passed = false;
+        }
+    }
+
+    /* A full segment cut short to look final must not authenticate. */
+    chacha20_stream_init_pull(&stream_st, aead_key, stream_header);
+    if (chacha20_stream_pull(&stream_st, stream_ct, STREAM_WIRE - 1, stream_out,
+                             &stream_final) != -1) {
+        passed = false;
+    }
+
+    printf("AEAD Stream Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* ChaCha20 RNG Test (outputs differ and are not stuck at zero) */
+    passed = true;
+
+    uint8_t rng_a[100];
+    uint8_t rng_b[100];
+    size_t rng_equal = 0;
+    size_t rng_zero = 0;
+
+    if (chacha20_rng_bytes(rng_a, sizeof(rng_a)) != 0 ||
+        chacha20_rng_bytes(rng_b, sizeof(rng_b)) != 0) {
+        passed = false;
+    }
+
+    for (size_t i = 0; i < sizeof(rng_a); i++) {
+        rng_equal += rng_a[i] == rng_b[i];
+        rng_zero += rng_a[i] == 0;
+    }
+
+    if (rng_equal == sizeof(rng_a) || rng_zero == sizeof(rng_a) ||
+        chacha20_rng_u64() == chacha20_rng_u64()) {
+        passed = false;
+    }
+
+    printf("ChaCha20 RNG Test -> ");
+    if (passed) {
+        printf("Passed\n");
+    } else {
+        printf("Failed\n");
+    }
+
+
+    /* Keystream Backend Tests (RFC 8439 vectors on every supported kernel) */
+    static const struct {
+        chacha20_backend_t backend;
+        const char *name;
+        size_t lanes;
+    } backends[] = {
+        { CHACHA20_BACKEND_SCALAR, "Scalar", 1 },
+        { CHACHA20_BACKEND_SSSE3, "SSSE3", 4 },
+        { CHACHA20_BACKEND_AVX2, "AVX2", 8 },
+        { CHACHA20_BACKEND_AVX512, "AVX-512", 16 }
+    };
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        printf("ChaCha20 %s Backend Test -> ", backends[b].name);
+        if (chacha20_set_backend(backends[b].backend) != 0) {
+            printf("Skipped (unsupported CPU)\n");
+            continue;
+        }
+
+        passed = true;
+
+        chacha20_apply(chacha20_key, chacha20_counter, chacha20_nonce, chacha20_pt, 114, chacha20_ct);
+        for (size_t i = 0; i < 114; i++) {
+            if (chacha20_ct[i] != chacha20_expected_ct[i]) {
+                passed = false;
+            }
+        }
+
+        chacha20_poly1305_encrypt(aead_key, aead_iv, aead_constant, aead_pt, 114,
+                                  aead_aad, 12, aead_ct, aead_tag);
+        for (size_t i = 0; i < 114; i++) {
+            if (aead_ct[i] != aead_expected_ct[i]) {
+                passed = false;
+            }
+        }
+        for (size_t i = 0; i < 16; i++) {
+            if (aead_tag[i] != aead_expected_tag[i]) {
+                passed = false;
+            }
+        }
+
+        /*
+         * Multi-state blocks must match one block per state for every count
+         * up to two full passes plus one, covering the row-layout kernels,
+         * the padded wide pass and the gather loads. Every word differs
+         * between states so a misplaced lane shows up.
+         */
+        static uint32_t multi_states[33][16];
+        static uint8_t multi_out[33 * 64];
+        chacha20_ctx_t multi_ctx;
+        uint8_t multi_block[64];
+
+        chacha20_ctx_init(&multi_ctx, chacha20_key, chacha20_nonce);
+        for (size_t i = 0; i < 33; i++) {
+            for (size_t w = 0; w < 16; w++) {
+                multi_states[i][w] = multi_ctx.state[w] + (uint32_t)(i * (w + 1)) * 0x9e3779b9u;
+            }
+        }
+        for (size_t count = 1; count <= 2 * backends[b].lanes + 1; count++) {
+            chacha20_blocks_multi(multi_states, count, multi_out);
+            for (size_t i = 0; i < count; i++) {
+                for (size_t w = 0; w < 16; w++) {
+                    multi_ctx.state[w] = multi_states[i][w];
+                }
+                chacha20_ctx_block(&multi_ctx, multi_block);
+                for (size_t k = 0; k < 64; k++) {
+                    if (multi_out[64 * i + k] != multi_block[k]) {
+                        passed = false;
+                    }
+                }
+            }
+        }
+
+        /* Batch sealing must match sealing each packet on its own. */
+        enum { BATCH_PACKETS = 21 };
+        static const size_t batch_len[BATCH_PACKETS] = {
+            0, 1, 63, 64, 65, 114, 127, 128, 129, 200, 0, 300, 17, 1023, 1024,
+            1300, 5, 64, 191, 256, 99
+        };
+        chacha20_poly1305_packet_t batch[BATCH_PACKETS];
+        uint8_t batch_iv[BATCH_PACKETS][8];
+        uint8_t batch_tag[BATCH_PACKETS][16];
+        static uint8_t batch_ct[BATCH_PACKETS][sizeof(chacha20_mb_data)];
+        for (size_t i = 0; i < BATCH_PACKETS; i++) {
+            for (size_t k = 0; k < 8; k++) {
+                batch_iv[i][k] = (uint8_t)(aead_iv[k] + i);
+            }
+            batch[i] = (chacha20_poly1305_packet_t){
+                batch_iv[i], aead_aad, i % 12, chacha20_mb_data + i % 8, batch_len[i],
+                batch_ct[i], batch_tag[i]
+            };
+        }
+        chacha20_poly1305_encrypt_batch(aead_key, aead_constant, batch, BATCH_PACKETS);
+        for (size_t i = 0; i < BATCH_PACKETS; i++) {
+            uint8_t single_ct[sizeof(chacha20_mb_data)];
+            uint8_t single_tag[16];
+            chacha20_poly1305_encrypt(aead_key, batch_iv[i], aead_constant,
+                                      chacha20_mb_data + i % 8, batch_len[i], aead_aad,
+                                      i % 12, single_ct, single_tag);
+            for (size_t k = 0; k < batch_len[i]; k++) {
+                if (batch_ct[i][k] != single_ct[k]) {
+                    passed = false;
+                }
+            }
+            for (size_t k = 0; k < 16; k++) {
+                if (batch_tag[i][k] != single_tag[k]) {
+                    passed = false;
+                }
+            }
+        }
+
+        uint8_t backend_mb_out[sizeof(chacha20_mb_data)];
+        chacha20_apply(chacha20_key, chacha20_counter, chacha20_nonce,
+                       chacha20_mb_data, sizeof(chacha20_mb_data), backend_mb_out);
+        for (size_t i = 0; i < sizeof(chacha20_mb_data); i++) {
+            if (backend_mb_out[i] != chacha20_mb_out[i]) {
+                passed = false;
+            }
+        }
+
+        if (passed) {
+            printf("Passed\n");
+        } else {
+            printf("Failed\n");
+        }
+    }
+
+    chacha20_set_backend(CHACHA20_BACKEND_AUTO);
+
     return 0;
 }
@@ -1,70 +1,545 @@
 #include "poly1305.h"
 #include <stdint.h>
 #include <stddef.h>
-#include <stdio.h>
-#include "bigint.h"
+#include <string.h>
 #include "chacha20.h"
+#include "cpu_features.h"
+#include "poly1305_internal.h"
+#include "poly1305_simd.h"
 
-int poly1305_mac(const uint8_t key[32], const uint8_t *msg, size_t msg_len,
-                 uint8_t tag[16])
+/*
+ * Fixed-size arithmetic modulo p = 2^130 - 5, with no heap use.
+ *
+ * With a native 128-bit product (__int128) the accumulator and r are held
+ * in three limbs of 44, 44 and 42 bits; otherwise in five 26-bit limbs with
+ * 64-bit products. In both layouts the multiplication by r folds the limbs
+ * above 2^130 back in multiplied by 5 (2^130 = 5 mod p) and the result is
+ * only partially reduced: limbs may slightly exceed their width between
+ * blocks, and the single full reduction happens in poly1305_finish().
+ */
+
+static inline uint32_t load32_le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static inline void store32_le(uint8_t *p, uint32_t w)
 {
-    /* Creation of (r, s). */
-    uint8_t r[16];
-    uint8_t s[16];
+    p[0] = (uint8_t)w;
+    p[1] = (uint8_t)(w >> 8);
+    p[2] = (uint8_t)(w >> 16);
+    p[3] = (uint8_t)(w >> 24);
+}
+
+#if defined(__SIZEOF_INT128__)
+
+typedef unsigned __int128 uint128_t;
+
+#define MASK44 0xfffffffffffull
+#define MASK42 0x3ffffffffffull
+
+static inline uint64_t load64_le(const uint8_t *p)
+{
+    return (uint64_t)load32_le(p) | ((uint64_t)load32_le(p + 4) << 32);
+}
+
+static inline void store64_le(uint8_t *p, uint64_t w)
+{
+    store32_le(p, (uint32_t)w);
+    store32_le(p + 4, (uint32_t)(w >> 32));
+}
+
+static void poly1305_setup(poly1305_state_t *st, const uint8_t key[32])
+{
+    uint64_t t0 = load64_le(key);
+    uint64_t t1 = load64_le(key + 8);
+
+    /* r, clamped (see poly1305_clamp()) while splitting into limbs. */
+    st->r[0] = t0 & 0xffc0fffffffull;
+    st->r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffull;
+    st->r[2] = (t1 >> 24) & 0x00ffffffc0full;
 
-    for (size_t i = 0; i < 16; i++) {
-        r[i] = key[i];
-        s[i] = key[16 + i];
+    st->h[0] = 0;
+    st->h[1] = 0;
+    st->h[2] = 0;
+
+    st->pad[0] = load64_le(key + 16);
+    st->pad[1] = load64_le(key + 24);
+
+    st->r_pow_ready = 0;
+}
+
+/**
+ * @brief Absorbs whole 16-byte blocks: h = (h + m) * r for each block.
+ *
+ * @param hibit 2^128 in limb-2 position for full blocks, 0 for the padded
+ *              final block (which carries its own 0x01 byte).
+ */
+static void poly1305_blocks(poly1305_state_t *st, const uint8_t *m,
+                            size_t bytes, uint64_t hibit)
+{
+    const uint64_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2];
+    /* Limb products landing at 2^132 fold back as 4 * 5 = 20. */
+    const uint64_t s1 = r1 * 20, s2 = r2 * 20;
+    uint64_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2];
+
+    while (bytes >= 16) {
+        uint64_t t0 = load64_le(m);
+        uint64_t t1 = load64_le(m + 8);
+
+        h0 += t0 & MASK44;
+        h1 += ((t0 >> 44) | (t1 << 20)) & MASK44;
+        h2 += ((t1 >> 24) & MASK42) | hibit;
+
+        uint128_t d0 = (uint128_t)h0 * r0 + (uint128_t)h1 * s2 + (uint128_t)h2 * s1;
+        uint128_t d1 = (uint128_t)h0 * r1 + (uint128_t)h1 * r0 + (uint128_t)h2 * s2;
+        uint128_t d2 = (uint128_t)h0 * r2 + (uint128_t)h1 * r1 + (uint128_t)h2 * r0;
+
+        /* Partial reduction: carry once through the limbs, fold the top. */
+        uint64_t c = (uint64_t)(d0 >> 44); h0 = (uint64_t)d0 & MASK44;
+        d1 += c; c = (uint64_t)(d1 >> 44); h1 = (uint64_t)d1 & MASK44;
+        d2 += c; c = (uint64_t)(d2 >> 42); h2 = (uint64_t)d2 & MASK42;
+        h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+        h1 += c;
+
+        m += 16;
+        bytes -= 16;
     }
 
-    /* Clamping of r. */
-    poly1305_clamp(r);
+    st->h[0] = h0;
+    st->h[1] = h1;
+    st->h[2] = h2;
+}
+
+static void poly1305_finish(poly1305_state_t *st, uint8_t tag[16])
+{
+    uint64_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2];
+    uint64_t c, g0, g1, g2;
+
+    /* Full carry, twice, so that h < 2^130. */
+    c = h1 >> 44; h1 &= MASK44;
+    h2 += c; c = h2 >> 42; h2 &= MASK42;
+    h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+    h1 += c; c = h1 >> 44; h1 &= MASK44;
+    h2 += c; c = h2 >> 42; h2 &= MASK42;
+    h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+    h1 += c;
 
-    /* Setup bigint_t numbers. */
-    bigint_t r_num = bigint_from_le_bytes(1, 16, r);
-    bigint_t s_num = bigint_from_le_bytes(1, 16, s);
-    bigint_t acc = bigint_alloc(0, 0);
-    bigint_t P = bigint_from_be_hex(1, "3fffffffffffffffffffffffffffffffb");
+    /* g = h + 5 - 2^130 = h - p */
+    g0 = h0 + 5; c = g0 >> 44; g0 &= MASK44;
+    g1 = h1 + c; c = g1 >> 44; g1 &= MASK44;
+    g2 = h2 + c - (1ull << 42);
+
+    /* Constant-time select: h if h < p (g negative), else g. */
+    c = (g2 >> 63) - 1;
+    g0 &= c; g1 &= c; g2 &= c;
+    c = ~c;
+    h0 = (h0 & c) | g0;
+    h1 = (h1 & c) | g1;
+    h2 = (h2 & c) | g2;
+
+    /* tag = (h + s) mod 2^128 */
+    uint64_t t0 = st->pad[0], t1 = st->pad[1];
+    h0 += t0 & MASK44; c = h0 >> 44; h0 &= MASK44;
+    h1 += (((t0 >> 44) | (t1 << 20)) & MASK44) + c; c = h1 >> 44; h1 &= MASK44;
+    h2 += ((t1 >> 24) & MASK42) + c; h2 &= MASK42;
+
+    store64_le(tag, h0 | (h1 << 44));
+    store64_le(tag + 8, (h1 >> 20) | (h2 << 24));
+}
 
-    size_t full_blocks_no = msg_len / 16;
-    size_t remaining = msg_len % 16;
+#define POLY1305_HIBIT (1ull << 40)
 
-    for (size_t i = 0; i < full_blocks_no; i++) {
-        uint8_t coeff[17] = {0};
-        for (size_t j = 0; j < 16; j++) {
-            coeff[j] = msg[i * 16 + j];
+#define FE_LIMBS 3
+typedef uint64_t fe_limb_t;
+
+/* out = a * b mod p, partially reduced; out may alias a or b. */
+static void fe_mul(uint64_t out[3], const uint64_t a[3], const uint64_t b[3])
+{
+    const uint64_t s1 = b[1] * 20, s2 = b[2] * 20;
+
+    uint128_t d0 = (uint128_t)a[0] * b[0] + (uint128_t)a[1] * s2 + (uint128_t)a[2] * s1;
+    uint128_t d1 = (uint128_t)a[0] * b[1] + (uint128_t)a[1] * b[0] + (uint128_t)a[2] * s2;
+    uint128_t d2 = (uint128_t)a[0] * b[2] + (uint128_t)a[1] * b[1] + (uint128_t)a[2] * b[0];
+
+    uint64_t c = (uint64_t)(d0 >> 44); out[0] = (uint64_t)d0 & MASK44;
+    d1 += c; c = (uint64_t)(d1 >> 44); out[1] = (uint64_t)d1 & MASK44;
+    d2 += c; c = (uint64_t)(d2 >> 42); out[2] = (uint64_t)d2 & MASK42;
+    out[0] += c * 5; c = out[0] >> 44; out[0] &= MASK44;
+    out[1] += c;
+}
+
+/* One carry pass, leaving h partially reduced as poly1305_blocks() does. */
+static void fe_carry(uint64_t h[3])
+{
+    uint64_t c;
+
+    c = h[0] >> 44; h[0] &= MASK44;
+    h[1] += c; c = h[1] >> 44; h[1] &= MASK44;
+    h[2] += c; c = h[2] >> 42; h[2] &= MASK42;
+    h[0] += c * 5; c = h[0] >> 44; h[0] &= MASK44;
+    h[1] += c;
+}
+
+#if defined(POLY1305_HAVE_AVX2)
+
+/* Messages shorter than this stay on the scalar path. */
+#define POLY1305_AVX2_MIN_BYTES 256
+
+/*
+ * Re-splits a 44/44/42-bit element into 26-bit limbs. The pieces are added
+ * rather than masked, so slightly oversized (partially reduced) limbs carry
+ * over exactly and every output limb stays below 2^27.
+ */
+static void limbs44_to_26(const uint64_t in[3], uint64_t out[5])
+{
+    out[0] = in[0] & 0x3ffffff;
+    out[1] = (in[0] >> 26) + ((in[1] & 0xff) << 18);
+    out[2] = (in[1] >> 8) & 0x3ffffff;
+    out[3] = (in[1] >> 34) + ((in[2] & 0xffff) << 10);
+    out[4] = in[2] >> 16;
+}
+
+/* Inverse of limbs44_to_26(), after one carry pass over the 26-bit limbs. */
+static void limbs26_to_44(uint64_t in[5], uint64_t out[3])
+{
+    uint64_t c;
+
+    c = in[0] >> 26; in[0] &= 0x3ffffff;
+    in[1] += c; c = in[1] >> 26; in[1] &= 0x3ffffff;
+    in[2] += c; c = in[2] >> 26; in[2] &= 0x3ffffff;
+    in[3] += c; c = in[3] >> 26; in[3] &= 0x3ffffff;
+    in[4] += c; c = in[4] >> 26; in[4] &= 0x3ffffff;
+    in[0] += c * 5; c = in[0] >> 26; in[0] &= 0x3ffffff;
+    in[1] += c;
+
+    uint64_t t = in[0] + (in[1] << 26);
+    out[0] = t & MASK44;
+    t = (t >> 44) + (in[2] << 8) + (in[3] << 34);
+    out[1] = t & MASK44;
+    out[2] = (t >> 44) + (in[4] << 16);
+}
+
+/* Computes r^1..r^4 once per key, in the layout the AVX2 kernel expects. */
+static void poly1305_powers(poly1305_state_t *st)
+{
+    uint64_t pow[4][3];
+    uint64_t limbs[5];
+
+    pow[0][0] = st->r[0]; pow[0][1] = st->r[1]; pow[0][2] = st->r[2];
+    fe_mul(pow[1], pow[0], pow[0]);
+    fe_mul(pow[2], pow[1], pow[0]);
+    fe_mul(pow[3], pow[1], pow[1]);
+
+    for (int i = 0; i < 4; i++) {
+        limbs44_to_26(pow[i], limbs);
+        for (int k = 0; k < 5; k++) {
+            st->r_pow[i][k] = (uint32_t)limbs[k];
         }
-        coeff[16] = 0x01;
+    }
+
+    st->r_pow_ready = 1;
+}
+
+/**
+ * @brief Hands long runs of full blocks to the AVX2 kernel.
+ *
+ * @return The number of bytes absorbed (a multiple of 64, possibly 0); the
+ *         caller finishes the rest on the scalar path.
+ */
+static size_t poly1305_blocks_simd(poly1305_state_t *st, const uint8_t *m,
+                                   size_t bytes)
+{
+    if (bytes < POLY1305_AVX2_MIN_BYTES || !(cpu_features() & CPU_FEATURE_AVX2)) {
+        return 0;
+    }
 
-        bigint_t n = bigint_from_le_bytes(1, 17, coeff);
-        bigint_add(&acc, &acc, &n);         // acc += n
-        bigint_mul(&acc, &acc, &r_num);     // acc *= r
-        bigint_mod(&acc, &acc, &P);         // acc %= P
-        bigint_free(&n);
+    if (!st->r_pow_ready) {
+        poly1305_powers(st);
     }
 
-    if (remaining) {
-        uint8_t coeff[17] = {0};
-        for (size_t j = 0; j < remaining; j++) {
-            coeff[j] = msg[full_blocks_no * 16 + j];
+    uint64_t h[5];
+    size_t simd_bytes = bytes & ~(size_t)63;
+
+    limbs44_to_26(st->h, h);
+    poly1305_blocks_avx2(h, (const uint32_t (*)[5])st->r_pow, m, simd_bytes);
+    limbs26_to_44(h, st->h);
+
+    return simd_bytes;
+}
+
+#endif /* POLY1305_HAVE_AVX2 */
+
+#else /* !__SIZEOF_INT128__ */
+
+#define MASK26 0x3ffffffu
+
+static void poly1305_setup(poly1305_state_t *st, const uint8_t key[32])
+{
+    /* r, clamped (see poly1305_clamp()) while splitting into limbs. */
+    st->r[0] = load32_le(key) & 0x3ffffff;
+    st->r[1] = (load32_le(key + 3) >> 2) & 0x3ffff03;
+    st->r[2] = (load32_le(key + 6) >> 4) & 0x3ffc0ff;
+    st->r[3] = (load32_le(key + 9) >> 6) & 0x3f03fff;
+    st->r[4] = (load32_le(key + 12) >> 8) & 0x00fffff;
+
+    for (int i = 0; i < 5; i++) {
+        st->h[i] = 0;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        st->pad[i] = load32_le(key + 16 + 4 * i);
+    }
+}
+
+/**
+ * @brief Absorbs whole 16-byte blocks: h = (h + m) * r for each block.
+ *
+ * @param hibit 2^128 in limb-4 position for full blocks, 0 for the padded
+ *              final block (which carries its own 0x01 byte).
+ */
+static void poly1305_blocks(poly1305_state_t *st, const uint8_t *m,
+                            size_t bytes, uint32_t hibit)
+{
+    const uint32_t r0 = st->r[0], r1 = st->r[1], r2 = st->r[2],
+                   r3 = st->r[3], r4 = st->r[4];
+    /* Limb products landing at 2^130 and above fold back multiplied by 5. */
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2],
+             h3 = st->h[3], h4 = st->h[4];
+
+    while (bytes >= 16) {
+        h0 += load32_le(m) & MASK26;
+        h1 += (load32_le(m + 3) >> 2) & MASK26;
+        h2 += (load32_le(m + 6) >> 4) & MASK26;
+        h3 += (load32_le(m + 9) >> 6) & MASK26;
+        h4 += (load32_le(m + 12) >> 8) | hibit;
+
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 +
+                      (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 +
+                      (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 +
+                      (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 +
+                      (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 +
+                      (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        /* Partial reduction: carry once through the limbs, fold the top. */
+        uint32_t c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & MASK26;
+        d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & MASK26;
+        d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & MASK26;
+        d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & MASK26;
+        d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & MASK26;
+        h0 += c * 5; c = h0 >> 26; h0 &= MASK26;
+        h1 += c;
+
+        m += 16;
+        bytes -= 16;
+    }
+
+    st->h[0] = h0; st->h[1] = h1; st->h[2] = h2; st->h[3] = h3; st->h[4] = h4;
+}
+
+static void poly1305_finish(poly1305_state_t *st, uint8_t tag[16])
+{
+    uint32_t h0 = st->h[0], h1 = st->h[1], h2 = st->h[2],
+             h3 = st->h[3], h4 = st->h[4];
+    uint32_t c, g0, g1, g2, g3, g4, mask;
+
+    /* Full carry so that h < 2^130. */
+    c = h1 >> 26; h1 &= MASK26;
+    h2 += c; c = h2 >> 26; h2 &= MASK26;
+    h3 += c; c = h3 >> 26; h3 &= MASK26;
+    h4 += c; c = h4 >> 26; h4 &= MASK26;
+    h0 += c * 5; c = h0 >> 26; h0 &= MASK26;
+    h1 += c;
+
+    /* g = h + 5 - 2^130 = h - p */
+    g0 = h0 + 5; c = g0 >> 26; g0 &= MASK26;
+    g1 = h1 + c; c = g1 >> 26; g1 &= MASK26;
+    g2 = h2 + c; c = g2 >> 26; g2 &= MASK26;
+    g3 = h3 + c; c = g3 >> 26; g3 &= MASK26;
+    g4 = h4 + c - (1u << 26);
+
+    /* Constant-time select: h if h < p (g negative), else g. */
+    mask = (g4 >> 31) - 1;
+    g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    /* Repack into 32-bit words, then tag = (h + s) mod 2^128. */
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    uint64_t f;
+    f = (uint64_t)h0 + st->pad[0]; store32_le(tag, (uint32_t)f);
+    f = (uint64_t)h1 + st->pad[1] + (f >> 32); store32_le(tag + 4, (uint32_t)f);
+    f = (uint64_t)h2 + st->pad[2] + (f >> 32); store32_le(tag + 8, (uint32_t)f);
+    f = (uint64_t)h3 + st->pad[3] + (f >> 32); store32_le(tag + 12, (uint32_t)f);
+}
+
+#define POLY1305_HIBIT (1u << 24)
+
+#define FE_LIMBS 5
+typedef uint32_t fe_limb_t;
+
+/* out = a * b mod p, partially reduced; out may alias a or b. */
+static void fe_mul(uint32_t out[5], const uint32_t a[5], const uint32_t b[5])
+{
+    const uint64_t s1 = (uint64_t)b[1] * 5, s2 = (uint64_t)b[2] * 5,
+                   s3 = (uint64_t)b[3] * 5, s4 = (uint64_t)b[4] * 5;
+
+    uint64_t d0 = (uint64_t)a[0] * b[0] + a[1] * s4 + a[2] * s3 + a[3] * s2 + a[4] * s1;
+    uint64_t d1 = (uint64_t)a[0] * b[1] + (uint64_t)a[1] * b[0] + a[2] * s4 + a[3] * s3 + a[4] * s2;
+    uint64_t d2 = (uint64_t)a[0] * b[2] + (uint64_t)a[1] * b[1] + (uint64_t)a[2] * b[0] +
+                  a[3] * s4 + a[4] * s3;
+    uint64_t d3 = (uint64_t)a[0] * b[3] + (uint64_t)a[1] * b[2] + (uint64_t)a[2] * b[1] +
+                  (uint64_t)a[3] * b[0] + a[4] * s4;
+    uint64_t d4 = (uint64_t)a[0] * b[4] + (uint64_t)a[1] * b[3] + (uint64_t)a[2] * b[2] +
+                  (uint64_t)a[3] * b[1] + (uint64_t)a[4] * b[0];
+
+    uint64_t c = d0 >> 26; d0 &= MASK26;
+    d1 += c; c = d1 >> 26; d1 &= MASK26;
+    d2 += c; c = d2 >> 26; d2 &= MASK26;
+    d3 += c; c = d3 >> 26; d3 &= MASK26;
+    d4 += c; c = d4 >> 26; d4 &= MASK26;
+    d0 += c * 5; c = d0 >> 26; d0 &= MASK26;
+    d1 += c;
+
+    out[0] = (uint32_t)d0; out[1] = (uint32_t)d1; out[2] = (uint32_t)d2;
+    out[3] = (uint32_t)d3; out[4] = (uint32_t)d4;
+}
+
+/* One carry pass, leaving h partially reduced as poly1305_blocks() does. */
+static void fe_carry(uint32_t h[5])
+{
+    uint32_t c;
+
+    c = h[0] >> 26; h[0] &= MASK26;
+    h[1] += c; c = h[1] >> 26; h[1] &= MASK26;
+    h[2] += c; c = h[2] >> 26; h[2] &= MASK26;
+    h[3] += c; c = h[3] >> 26; h[3] &= MASK26;
+    h[4] += c; c = h[4] >> 26; h[4] &= MASK26;
+    h[0] += c * 5; c = h[0] >> 26; h[0] &= MASK26;
+    h[1] += c;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+/* out = r^n, by square-and-multiply. */
+static void fe_pow_r(const poly1305_state_t *st, uint64_t n, fe_limb_t out[FE_LIMBS])
+{
+    fe_limb_t base[FE_LIMBS];
+
+    for (int i = 0; i < FE_LIMBS; i++) {
+        base[i] = st->r[i];
+        out[i] = 0;
+    }
+    out[0] = 1;
+
+    while (n) {
+        if (n & 1) {
+            fe_mul(out, out, base);
+        }
+        n >>= 1;
+        if (n) {
+            fe_mul(base, base, base);
+        }
+    }
+}
+
+void poly1305_combine(poly1305_state_t *acc, const poly1305_state_t *part,
+                      uint64_t part_blocks)
+{
+    fe_limb_t r_n[FE_LIMBS];
+
+    fe_pow_r(acc, part_blocks, r_n);
+    fe_mul(acc->h, acc->h, r_n);
+
+    for (int i = 0; i < FE_LIMBS; i++) {
+        acc->h[i] += part->h[i];
+    }
+    fe_carry(acc->h);
+}
+
+void poly1305_init(poly1305_state_t *st, const uint8_t key[32])
+{
+    poly1305_setup(st, key);
+    st->leftover = 0;
+}
+
+void poly1305_update(poly1305_state_t *st, const uint8_t *data, size_t len)
+{
+    /* Complete a block started by an earlier call. */
+    if (st->leftover) {
+        size_t want = 16 - st->leftover;
+        if (want > len) {
+            want = len;
+        }
+
+        memcpy(st->buffer + st->leftover, data, want);
+        st->leftover += want;
+        data += want;
+        len -= want;
+
+        if (st->leftover < 16) {
+            return;
         }
-        coeff[remaining] = 0x01;
+        poly1305_blocks(st, st->buffer, 16, POLY1305_HIBIT);
+        st->leftover = 0;
+    }
+
+    size_t full = len & ~(size_t)15;
+    if (full) {
+#if defined(POLY1305_HAVE_AVX2)
+        size_t simd = poly1305_blocks_simd(st, data, full);
+        data += simd;
+        len -= simd;
+        full -= simd;
+#endif
+        if (full) {
+            poly1305_blocks(st, data, full, POLY1305_HIBIT);
+            data += full;
+            len -= full;
+        }
+    }
 
-        bigint_t n = bigint_from_le_bytes(1, 17, coeff);
-        bigint_add(&acc, &acc, &n);
-        bigint_mul(&acc, &acc, &r_num);
-        bigint_mod(&acc, &acc, &P);
-        bigint_free(&n);
+    if (len) {
+        memcpy(st->buffer, data, len);
+        st->leftover = len;
     }
+}
 
-    bigint_add(&acc, &acc, &s_num);
+void poly1305_final(poly1305_state_t *st, uint8_t tag[16])
+{
+    /* Last partial block: append 0x01 and zero-pad, with no 2^128 bit. */
+    if (st->leftover) {
+        st->buffer[st->leftover] = 0x01;
+        memset(st->buffer + st->leftover + 1, 0, 15 - st->leftover);
+        poly1305_blocks(st, st->buffer, 16, 0);
+        st->leftover = 0;
+    }
 
-    bigint_to_le_bytes(&acc, tag, 16);
+    poly1305_finish(st, tag);
+}
 
-    bigint_free(&r_num);
-    bigint_free(&s_num);
-    bigint_free(&acc);
-    bigint_free(&P);
+int poly1305_mac(const uint8_t key[32], const uint8_t *msg, size_t msg_len,
+                 uint8_t tag[16])
+{
+    poly1305_state_t st;
+
+    poly1305_init(&st, key);
+    poly1305_update(&st, msg, msg_len);
+    poly1305_final(&st, tag);
 
     return 0;
 }
@@ -72,13 +547,15 @@ int poly1305_mac(const uint8_t key[32], const uint8_t *msg, size_t msg_len,
 int poly1305_key_gen(const uint8_t chacha_key[32], const uint8_t nonce[12],
                      uint8_t poly_key[32])
 {
+    chacha20_ctx_t ctx;
     uint8_t keystream[64];
 
-    chacha20_block(chacha_key, 0, nonce, keystream);
+    chacha20_ctx_init(&ctx, chacha_key, nonce);
+    chacha20_ctx_block(&ctx, keystream);
 
     for (int i = 0; i < 32; i++) {
         poly_key[i] = keystream[i];
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,123 @@
+#include "poly1305_simd.h"
+
+#if defined(POLY1305_HAVE_AVX2)
+#include <immintrin.h>
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+/*
+ * Every 64-bit lane holds one 26-bit limb of one accumulator, so the
+ * 32x32->64 vpmuludq products of the schoolbook multiplication never
+ * overflow: limbs stay below 2^28, (5 *) r limbs below 2^29, and a sum of
+ * five products below 2^60.
+ */
+
+/* Splits four consecutive 16-byte blocks into 26-bit limbs, one block per lane. */
+AVX2_TARGET
+static inline void load_blocks(const uint8_t *m, __m256i l[5])
+{
+    const __m256i mask26 = _mm256_set1_epi64x(0x3ffffff);
+    const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+
+    __m256i m0 = _mm256_loadu_si256((const __m256i *)m);
+    __m256i m1 = _mm256_loadu_si256((const __m256i *)(m + 32));
+    __m256i t0 = _mm256_permute2x128_si256(m0, m1, 0x20);
+    __m256i t1 = _mm256_permute2x128_si256(m0, m1, 0x31);
+    __m256i lo = _mm256_unpacklo_epi64(t0, t1);  /* bytes 0..7 of blocks 0..3 */
+    __m256i hi = _mm256_unpackhi_epi64(t0, t1);  /* bytes 8..15 of blocks 0..3 */
+
+    l[0] = _mm256_and_si256(lo, mask26);
+    l[1] = _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask26);
+    l[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),
+                                            _mm256_slli_epi64(hi, 12)), mask26);
+    l[3] = _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask26);
+    l[4] = _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit);
+}
+
+/* a = a * r mod p, lane by lane, followed by one partial carry pass. */
+AVX2_TARGET
+static inline void mul_reduce(__m256i a[5], const __m256i r[5], const __m256i s[5])
+{
+    const __m256i mask26 = _mm256_set1_epi64x(0x3ffffff);
+    __m256i d[5];
+
+#define MUL(x, y) _mm256_mul_epu32((x), (y))
+    d[0] = _mm256_add_epi64(_mm256_add_epi64(MUL(a[0], r[0]), MUL(a[1], s[4])),
+           _mm256_add_epi64(_mm256_add_epi64(MUL(a[2], s[3]), MUL(a[3], s[2])), MUL(a[4], s[1])));
+    d[1] = _mm256_add_epi64(_mm256_add_epi64(MUL(a[0], r[1]), MUL(a[1], r[0])),
+           _mm256_add_epi64(_mm256_add_epi64(MUL(a[2], s[4]), MUL(a[3], s[3])), MUL(a[4], s[2])));
+    d[2] = _mm256_add_epi64(_mm256_add_epi64(MUL(a[0], r[2]), MUL(a[1], r[1])),
+           _mm256_add_epi64(_mm256_add_epi64(MUL(a[2], r[0]), MUL(a[3], s[4])), MUL(a[4], s[3])));
+    d[3] = _mm256_add_epi64(_mm256_add_epi64(MUL(a[0], r[3]), MUL(a[1], r[2])),
+           _mm256_add_epi64(_mm256_add_epi64(MUL(a[2], r[1]), MUL(a[3], r[0])), MUL(a[4], s[4])));
+    d[4] = _mm256_add_epi64(_mm256_add_epi64(MUL(a[0], r[4]), MUL(a[1], r[3])),
+           _mm256_add_epi64(_mm256_add_epi64(MUL(a[2], r[2]), MUL(a[3], r[1])), MUL(a[4], r[0])));
+#undef MUL
+
+    __m256i c;
+    c = _mm256_srli_epi64(d[0], 26); a[0] = _mm256_and_si256(d[0], mask26);
+    d[1] = _mm256_add_epi64(d[1], c);
+    c = _mm256_srli_epi64(d[1], 26); a[1] = _mm256_and_si256(d[1], mask26);
+    d[2] = _mm256_add_epi64(d[2], c);
+    c = _mm256_srli_epi64(d[2], 26); a[2] = _mm256_and_si256(d[2], mask26);
+    d[3] = _mm256_add_epi64(d[3], c);
+    c = _mm256_srli_epi64(d[3], 26); a[3] = _mm256_and_si256(d[3], mask26);
+    d[4] = _mm256_add_epi64(d[4], c);
+    c = _mm256_srli_epi64(d[4], 26); a[4] = _mm256_and_si256(d[4], mask26);
+
+    /* 2^130 = 5 mod p */
+    a[0] = _mm256_add_epi64(a[0], _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+    c = _mm256_srli_epi64(a[0], 26); a[0] = _mm256_and_si256(a[0], mask26);
+    a[1] = _mm256_add_epi64(a[1], c);
+}
+
+AVX2_TARGET
+static inline uint64_t hsum(__m256i v)
+{
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+
+    return (uint64_t)_mm_cvtsi128_si64(_mm_add_epi64(s, _mm_unpackhi_epi64(s, s)));
+}
+
+AVX2_TARGET
+void poly1305_blocks_avx2(uint64_t h[5], const uint32_t r_pow[4][5],
+                          const uint8_t *m, size_t bytes)
+{
+    __m256i r[5], s[5], a[5], msg[5];
+
+    for (int k = 0; k < 5; k++) {
+        r[k] = _mm256_set1_epi64x(r_pow[3][k]);
+        s[k] = _mm256_set1_epi64x(5 * (uint64_t)r_pow[3][k]);
+    }
+
+    /* The running accumulator joins the first block of lane 0. */
+    load_blocks(m, a);
+    for (int k = 0; k < 5; k++) {
+        a[k] = _mm256_add_epi64(a[k], _mm256_set_epi64x(0, 0, 0, (long long)h[k]));
+    }
+    m += 64;
+    bytes -= 64;
+
+    while (bytes >= 64) {
+        mul_reduce(a, r, s);
+        load_blocks(m, msg);
+        for (int k = 0; k < 5; k++) {
+            a[k] = _mm256_add_epi64(a[k], msg[k]);
+        }
+        m += 64;
+        bytes -= 64;
+    }
+
+    /* Fold the lanes: lane j is multiplied by r^(4 - j). */
+    for (int k = 0; k < 5; k++) {
+        r[k] = _mm256_set_epi64x(r_pow[0][k], r_pow[1][k], r_pow[2][k], r_pow[3][k]);
+        s[k] = _mm256_set_epi64x(5 * (uint64_t)r_pow[0][k], 5 * (uint64_t)r_pow[1][k],
+                                 5 * (uint64_t)r_pow[2][k], 5 * (uint64_t)r_pow[3][k]);
+    }
+    mul_reduce(a, r, s);
+
+    for (int k = 0; k < 5; k++) {
+        h[k] = hsum(a[k]);
+    }
+}
+#endif /* POLY1305_HAVE_AVX2 */
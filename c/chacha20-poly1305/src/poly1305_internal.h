@@ -0,0 +1,25 @@
+#ifndef __POLY1305_INTERNAL__
+#define __POLY1305_INTERNAL__
+
+#include <stdint.h>
+#include "poly1305.h"
+
+/**
+ * @brief Appends a separately computed stretch of blocks to a MAC.
+ *
+ * Poly1305 is a polynomial in r, so a message can be MACed in pieces: each
+ * piece starts from h = 0 under the same key, and the pieces are joined as
+ * acc = acc * r^part_blocks + part. The result equals having fed the
+ * part's blocks to `acc` directly, and `acc` is left partially reduced like
+ * after poly1305_update(), so it may be finalized right away. Both states
+ * must have no buffered partial block; a piece ending in a short block must
+ * have been padded to 16 bytes.
+ *
+ * @param[in,out] acc         The MAC so far.
+ * @param[in]     part        The piece, absorbed from a fresh poly1305_init().
+ * @param[in]     part_blocks Number of 16-byte blocks absorbed into `part`.
+ */
+void poly1305_combine(poly1305_state_t *acc, const poly1305_state_t *part,
+                      uint64_t part_blocks);
+
+#endif /* __POLY1305_INTERNAL__ */
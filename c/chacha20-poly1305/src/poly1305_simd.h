@@ -0,0 +1,27 @@
+#ifndef __POLY1305_SIMD__
+#define __POLY1305_SIMD__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SIZEOF_INT128__)
+#define POLY1305_HAVE_AVX2 1
+
+/**
+ * @brief Absorbs 16-byte blocks four at a time in AVX2 lanes.
+ *
+ * Lane j accumulates blocks j, j + 4, j + 8, ... with one multiplication by
+ * r^4 per step; at the end lane j is multiplied by r^(4 - j) and the lanes
+ * are summed, which gives the same result as the serial Horner evaluation.
+ *
+ * @param[in,out] h       The accumulator in five 26-bit limbs (each limb
+ *                        below 2^27 on input; below 2^29 on output).
+ * @param[in]     r_pow   r^1..r^4 in 26-bit limbs (r_pow[i] = r^(i + 1)).
+ * @param[in]     m       The message blocks.
+ * @param[in]     bytes   Number of message bytes, a non-zero multiple of 64.
+ */
+void poly1305_blocks_avx2(uint64_t h[5], const uint32_t r_pow[4][5],
+                          const uint8_t *m, size_t bytes);
+#endif
+
+#endif /* __POLY1305_SIMD__ */
@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "thread_pool.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* Hard cap on pool size, whatever callers ask for. */
+#define THREAD_POOL_MAX_THREADS 256
+
+struct pool_job {
+    thread_pool_task_fn fn;
+    void *arg;
+    size_t tasks;            /* Total number of tasks */
+    size_t next;             /* Next task index to hand out */
+    size_t done;             /* Tasks completed */
+    size_t helpers;          /* Worker threads allowed to join */
+    pthread_cond_t finished; /* Signalled when done == tasks */
+    struct pool_job *link;   /* Next job in the pending queue */
+};
+
+/* All pool state is protected by pool_lock. */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static struct pool_job *pool_queue = NULL;
+static unsigned int pool_threads = 0;
+
+/* Removes a job from the pending queue once nothing is left to hand out. */
+static void queue_remove(struct pool_job *job)
+{
+    for (struct pool_job **p = &pool_queue; *p; p = &(*p)->link) {
+        if (*p == job) {
+            *p = job->link;
+            return;
+        }
+    }
+}
+
+/* Claims and runs tasks of `job` until none is left. Called with the lock held. */
+static void job_work(struct pool_job *job)
+{
+    while (job->next < job->tasks) {
+        size_t index = job->next++;
+        if (job->next == job->tasks) {
+            queue_remove(job);
+        }
+
+        pthread_mutex_unlock(&pool_lock);
+        job->fn(job->arg, index);
+        pthread_mutex_lock(&pool_lock);
+
+        if (++job->done == job->tasks) {
+            pthread_cond_broadcast(&job->finished);
+        }
+    }
+}
+
+static void *pool_worker(void *unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (!pool_queue) {
+            pthread_cond_wait(&pool_wake, &pool_lock);
+        }
+
+        struct pool_job *job = pool_queue;
+        if (job->helpers == 0) {
+            /* Enough threads on this job already: leave the rest to them. */
+            queue_remove(job);
+            continue;
+        }
+        job->helpers--;
+        job_work(job);
+    }
+
+    return NULL;
+}
+
+/* Starts worker threads until the pool holds `wanted`. Called with the lock held. */
+static void pool_grow(unsigned int wanted)
+{
+    if (wanted > THREAD_POOL_MAX_THREADS) {
+        wanted = THREAD_POOL_MAX_THREADS;
+    }
+
+    while (pool_threads < wanted) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, pool_worker, NULL) != 0) {
+            /* Not fatal: the caller and existing workers run the tasks. */
+            break;
+        }
+        pthread_detach(thread);
+        pool_threads++;
+    }
+}
+
+void thread_pool_run(size_t tasks, thread_pool_task_fn fn, void *arg,
+                     unsigned int max_threads)
+{
+    if (tasks == 0) {
+        return;
+    }
+
+    size_t helpers = max_threads > 1 ? max_threads - 1 : 0;
+    if (helpers > tasks - 1) {
+        helpers = tasks - 1;
+    }
+
+    if (helpers == 0) {
+        for (size_t i = 0; i < tasks; i++) {
+            fn(arg, i);
+        }
+        return;
+    }
+
+    struct pool_job job = {
+        .fn = fn, .arg = arg, .tasks = tasks, .next = 0, .done = 0,
+        .helpers = helpers, .link = NULL
+    };
+    pthread_cond_init(&job.finished, NULL);
+
+    pthread_mutex_lock(&pool_lock);
+    pool_grow((unsigned int)helpers);
+
+    struct pool_job **tail = &pool_queue;
+    while (*tail) {
+        tail = &(*tail)->link;
+    }
+    *tail = &job;
+    pthread_cond_broadcast(&pool_wake);
+
+    job_work(&job);
+    while (job.done < job.tasks) {
+        pthread_cond_wait(&job.finished, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    pthread_cond_destroy(&job.finished);
+}
+
+unsigned int thread_pool_cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (unsigned int)n : 1;
+}
@@ -0,0 +1,32 @@
+#ifndef __THREAD_POOL__
+#define __THREAD_POOL__
+
+#include <stddef.h>
+
+/**
+ * @brief Task body: runs task `index` of a job submitted to the pool.
+ */
+typedef void (*thread_pool_task_fn)(void *arg, size_t index);
+
+/**
+ * @brief Runs `tasks` independent tasks and waits for all of them.
+ *
+ * The calling thread works on the job too, so with a single task (or when no
+ * worker thread can be started) everything runs inline. Worker threads are
+ * started lazily, kept for the life of the process, and shared by every
+ * caller; at most `max_threads - 1` of them help on this job.
+ *
+ * @param[in] tasks       Number of tasks; task indices are 0..tasks-1.
+ * @param[in] fn          Task body.
+ * @param[in] arg         Opaque pointer passed to every task.
+ * @param[in] max_threads Upper bound on threads working on the job, caller included.
+ */
+void thread_pool_run(size_t tasks, thread_pool_task_fn fn, void *arg,
+                     unsigned int max_threads);
+
+/**
+ * @brief Returns the number of online CPUs (at least 1).
+ */
+unsigned int thread_pool_cpu_count(void);
+
+#endif /* __THREAD_POOL__ */
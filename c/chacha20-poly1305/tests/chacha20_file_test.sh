@@ -0,0 +1,90 @@
+#!/bin/sh
+# Round trips and failure cases for chacha20-file, on both the memory-mapped
+# path (named regular files) and the streamed path (pipes).
+#
+# usage: tests/chacha20_file_test.sh [path/to/chacha20-file]
+
+TOOL=${1:-./chacha20-file}
+DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$DIR"' EXIT INT TERM
+
+# Format constants: magic + stream header, and a 64 KiB segment with its tag.
+HEADER=24
+SEALED=65552
+
+failures=0
+
+check() {
+    name=$1
+    shift
+    if "$@"; then
+        echo "chacha20-file $name -> Passed"
+    else
+        echo "chacha20-file $name -> Failed"
+        failures=$((failures + 1))
+    fi
+}
+
+# Round trip of SIZE random bytes: mapped and piped, and each way across.
+round_trip() {
+    size=$1
+    in=$DIR/in.$size
+
+    head -c "$size" /dev/urandom > "$in" &&
+    "$TOOL" encrypt -q -k "$DIR/key" "$in" "$DIR/mapped.enc" &&
+    "$TOOL" decrypt -q -k "$DIR/key" "$DIR/mapped.enc" "$DIR/mapped.out" &&
+    cmp -s "$in" "$DIR/mapped.out" &&
+    cat "$in" | "$TOOL" encrypt -q -k "$DIR/key" | cat > "$DIR/piped.enc" &&
+    cat "$DIR/piped.enc" | "$TOOL" decrypt -q -k "$DIR/key" | cat > "$DIR/piped.out" &&
+    cmp -s "$in" "$DIR/piped.out" &&
+    "$TOOL" decrypt -q -k "$DIR/key" "$DIR/piped.enc" "$DIR/cross.out" &&
+    cmp -s "$in" "$DIR/cross.out" &&
+    cat "$DIR/mapped.enc" | "$TOOL" decrypt -q -k "$DIR/key" | cat > "$DIR/cross.out" &&
+    cmp -s "$in" "$DIR/cross.out"
+}
+
+# Decrypting ENC must fail on both paths and leave no output file behind.
+rejects() {
+    enc=$1
+
+    rm -f "$DIR/bad.out"
+    if "$TOOL" decrypt -q -k "$DIR/key" "$enc" "$DIR/bad.out" 2> /dev/null ||
+       [ -e "$DIR/bad.out" ]; then
+        return 1
+    fi
+    if cat "$enc" | "$TOOL" decrypt -q -k "$DIR/key" - "$DIR/bad.out" 2> /dev/null ||
+       [ -e "$DIR/bad.out" ]; then
+        return 1
+    fi
+    # No temporary file may be left either.
+    [ -z "$(ls "$DIR" | grep '^bad\.out')" ]
+}
+
+# Flips the low bit of the byte at OFFSET in FILE.
+flip_byte() {
+    byte=$(od -An -tu1 -j "$2" -N1 "$1" | tr -d ' ')
+    printf "\\$(printf '%03o' $((byte ^ 1)))" |
+        dd of="$1" bs=1 seek="$2" conv=notrunc 2> /dev/null
+}
+
+"$TOOL" keygen "$DIR/key" || exit 1
+
+check "0 B Round Trip" round_trip 0
+check "64 KiB Round Trip" round_trip 65536
+check "4 MiB Round Trip" round_trip 4194304
+check "Odd Size Round Trip" round_trip 200003
+
+# 4 MiB is 64 full segments plus an empty final one.
+"$TOOL" encrypt -q -k "$DIR/key" "$DIR/in.4194304" "$DIR/good.enc" || exit 1
+
+cp "$DIR/good.enc" "$DIR/flipped.enc"
+flip_byte "$DIR/flipped.enc" $((HEADER + 3 * SEALED + 100))
+check "Flipped Byte" rejects "$DIR/flipped.enc"
+
+head -c $((HEADER + 64 * SEALED)) "$DIR/good.enc" > "$DIR/truncated.enc"
+check "Final Segment Truncated" rejects "$DIR/truncated.enc"
+
+head -c $((HEADER + 32 * SEALED)) "$DIR/good.enc" > "$DIR/truncated.enc"
+check "Segment Boundary Truncated" rejects "$DIR/truncated.enc"
+
+[ "$failures" -eq 0 ]